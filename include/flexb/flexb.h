@@ -79,14 +79,20 @@ typedef struct FLEXB_root {
     const void * end;
 } FLEXB_root;
 
+typedef struct FLEXB_map_iter {
+    const FLEXB_map * map;
+    size_t index;
+    size_t end;
+} FLEXB_map_iter;
+
 typedef struct _FLEXB_key_cmp {
     const char* key;
     uint8_t width;
 } _FLEXB_key_cmp;
 
-inline const void * _flexb_indirect(const void* data, int width);
+static inline const void * _flexb_indirect(const void* data, int width);
 
-inline int flexb_set_root(const void* data, size_t length, FLEXB_root *root, FLEXB_ref* ref) {
+static inline int flexb_set_root(const void* data, size_t length, FLEXB_root *root, FLEXB_ref* ref) {
     if (data == NULL || ref == NULL || length < 3) {
         return EINVAL;
     }
@@ -104,7 +110,7 @@ inline int flexb_set_root(const void* data, size_t length, FLEXB_root *root, FLE
     return FLEXB_SUCCESS;
 }
 
-inline int64_t _flexb_get_int64(const void* data, int width) {
+static inline int64_t _flexb_get_int64(const void* data, int width) {
     int64_t num;
     switch (width) {
     case 1:
@@ -139,7 +145,7 @@ inline int64_t _flexb_get_int64(const void* data, int width) {
     return num;
 }
 
-inline uint64_t _flexb_get_uint64(const void* data, int width) {
+static inline uint64_t _flexb_get_uint64(const void* data, int width) {
     uint64_t num;
     switch (width) {
     case 1:
@@ -174,7 +180,7 @@ inline uint64_t _flexb_get_uint64(const void* data, int width) {
     return num;
 }
 
-inline double flexb_get_float(const void* data, int width) {
+static inline double flexb_get_float(const void* data, int width) {
     double num;
     switch (width) {
     /*
@@ -212,11 +218,11 @@ inline double flexb_get_float(const void* data, int width) {
     return num;
 }
 
-inline const void * _flexb_indirect(const void* data, int width) {
-    return data - _flexb_get_uint64(data, width);
+static inline const void * _flexb_indirect(const void* data, int width) {
+    return (const uint8_t*)data - _flexb_get_uint64(data, width);
 }
 
-inline int flexb_as_float(void *root, FLEXB_ref* ref, double *num) {
+static inline int flexb_as_float(void *root, FLEXB_ref* ref, double *num) {
     if (num == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -234,7 +240,7 @@ inline int flexb_as_float(void *root, FLEXB_ref* ref, double *num) {
     return FLEXB_INVALID_CONVERSION;
 }
 
-inline int flexb_as_int64(const FLEXB_ref* ref, int64_t *num) {
+static inline int flexb_as_int64(const FLEXB_ref* ref, int64_t *num) {
     if (num == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -264,7 +270,7 @@ inline int flexb_as_int64(const FLEXB_ref* ref, int64_t *num) {
     return FLEXB_INVALID_CONVERSION;
 }
 
-inline int flexb_as_uint64(const FLEXB_ref* ref, uint64_t *num) {
+static inline int flexb_as_uint64(const FLEXB_ref* ref, uint64_t *num) {
     if (num == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -294,7 +300,7 @@ inline int flexb_as_uint64(const FLEXB_ref* ref, uint64_t *num) {
     return FLEXB_INVALID_CONVERSION;
 }
 
-inline int flexb_as_bool(const void* root, const FLEXB_ref* ref, char *boolean) {
+static inline int flexb_as_bool(const void* root, const FLEXB_ref* ref, char *boolean) {
     if (boolean == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -307,7 +313,7 @@ inline int flexb_as_bool(const void* root, const FLEXB_ref* ref, char *boolean)
     return FLEXB_SUCCESS;
 }
 
-inline int flexb_as_str(const void* root, const FLEXB_ref* ref, const char **str) {
+static inline int flexb_as_str(const void* root, const FLEXB_ref* ref, const char **str) {
     if (str == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -316,13 +322,13 @@ inline int flexb_as_str(const void* root, const FLEXB_ref* ref, const char **str
         if (root != NULL && data < root) {
             return FLEXB_CORRUPTED;
         }
-        *str = data;
+        *str = (const char*)data;
         return FLEXB_SUCCESS;
     }
     return FLEXB_INVALID_CONVERSION;
 }
 
-inline int flexb_as_blob(const void* root, const FLEXB_ref* ref, const char **blob, size_t * length) {
+static inline int flexb_as_blob(const void* root, const FLEXB_ref* ref, const char **blob, size_t * length) {
     if (length == NULL || blob == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -331,7 +337,7 @@ inline int flexb_as_blob(const void* root, const FLEXB_ref* ref, const char **bl
         if (root != NULL && data < root) {
             return FLEXB_CORRUPTED;
         }
-        const void* size_offset = data - ref->byte_width;
+        const void* size_offset = (const uint8_t*)data - ref->byte_width;
         if (root != NULL && size_offset < root) {
             return FLEXB_CORRUPTED;
         }
@@ -342,7 +348,7 @@ inline int flexb_as_blob(const void* root, const FLEXB_ref* ref, const char **bl
     return FLEXB_INVALID_CONVERSION;
 }
 
-inline int flexb_as_vec(const void* root, const FLEXB_ref* ref, FLEXB_vec *vec) {
+static inline int flexb_as_vec(const void* root, const FLEXB_ref* ref, FLEXB_vec *vec) {
     if (ref == NULL || vec == NULL) {
             return EINVAL;
     }
@@ -360,7 +366,7 @@ inline int flexb_as_vec(const void* root, const FLEXB_ref* ref, FLEXB_vec *vec)
         length = (ref->type - FLEXB_VECTOR_INT2) / 3 + 2;
         type = (ref->type - FLEXB_VECTOR_INT2) % 3 + FLEXB_INT;
     } else {
-        const void* size_offset = data - ref->byte_width;
+        const void* size_offset = (const uint8_t*)data - ref->byte_width;
         if (root != NULL && size_offset < root) {
             return FLEXB_CORRUPTED;
         }
@@ -395,7 +401,7 @@ inline int flexb_as_vec(const void* root, const FLEXB_ref* ref, FLEXB_vec *vec)
     return FLEXB_SUCCESS;
 }
 
-inline int flexb_as_map(const void* root, const FLEXB_ref* ref, FLEXB_map *map) {
+static inline int flexb_as_map(const void* root, const FLEXB_ref* ref, FLEXB_map *map) {
     if (map == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -409,25 +415,44 @@ inline int flexb_as_map(const void* root, const FLEXB_ref* ref, FLEXB_map *map)
         return rc;
     }
     const void* data = _flexb_indirect(ref->data, ref->parent_width);
-    const void* keys_offset = data - (vec.byte_width * 3);
+    const void* keys_offset = (const uint8_t*)data - (vec.byte_width * 3);
     if (root != NULL && keys_offset < root) {
         return FLEXB_CORRUPTED;
     }
     map->values = vec;
     map->keys.data = _flexb_indirect(keys_offset, map->values.byte_width);
-    const void* keys_width_offset = keys_offset + map->values.byte_width;
+    const void* keys_width_offset = (const uint8_t*)keys_offset + map->values.byte_width;
     map->keys.byte_width = _flexb_get_uint64(keys_width_offset, map->values.byte_width);
     map->keys.type = FLEXB_KEY;
     map->keys.length =  vec.length;
     return FLEXB_SUCCESS;
 }
 
-int _key_compare(const void *a, const void* b) {
+static inline int flexb_map_get_at(const void* root, const FLEXB_map *map, size_t index, const char** key, FLEXB_ref* ref) {
+    if (map == NULL || ref == NULL) {
+        return EINVAL;
+    }
+    if (index >= map->values.length) {
+        return FLEXB_NOT_FOUND;
+    }
+    if (key != NULL) {
+        const void* data = _flexb_indirect((const uint8_t*)map->keys.data + (map->keys.byte_width * index), map->keys.byte_width);
+        if (root != NULL && data < root) {
+            return FLEXB_CORRUPTED;
+        }
+        *key = (const char*)data;
+    }
+    uint8_t packed_byte = *((const uint8_t*)map->values.data + (map->values.byte_width * map->values.length) + index);
+    SET_REF(ref, (const uint8_t*)map->values.data + (map->values.byte_width * index), map->values.byte_width, packed_byte);
+    return FLEXB_SUCCESS;
+}
+
+static int _key_compare(const void *a, const void* b) {
     _FLEXB_key_cmp *key = (_FLEXB_key_cmp*) a;
     return strcmp((const char* )key->key, (const char*)_flexb_indirect(b, key->width));
 }
 
-inline int flexb_map_get_ref(const void* root, FLEXB_map *map, const char* key, FLEXB_ref* ref) {
+static inline int flexb_map_get_ref(const void* root, FLEXB_map *map, const char* key, FLEXB_ref* ref) {
     if (map == NULL || key == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -436,13 +461,103 @@ inline int flexb_map_get_ref(const void* root, FLEXB_map *map, const char* key,
     if (item == NULL) {
         return FLEXB_NOT_FOUND;
     }
-    size_t index = (size_t)(item - map->keys.data) / map->keys.byte_width;
-    uint8_t packed_byte = *(const uint8_t*)(map->values.data + (map->values.byte_width * map->values.length) + index);
-    SET_REF(ref, map->values.data + (map->values.byte_width * index), map->values.byte_width, packed_byte);
+    size_t index = (size_t)((const uint8_t*)item - (const uint8_t*)map->keys.data) / map->keys.byte_width;
+    return flexb_map_get_at(root, map, index, NULL, ref);
+}
+
+static inline const char * _flexb_map_key(const FLEXB_map *map, size_t index) {
+    return (const char*)_flexb_indirect((const uint8_t*)map->keys.data + (map->keys.byte_width * index), map->keys.byte_width);
+}
+
+/*
+ * First index whose key compares greater than key when upper is set, greater
+ * or equal otherwise. A non zero n only compares the first n chars.
+ */
+static inline int _flexb_map_bound(const void* root, const FLEXB_map *map, const char* key, size_t n, int upper, size_t *index) {
+    size_t lo = 0;
+    size_t hi = map->keys.length;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const char* item = _flexb_map_key(map, mid);
+        if (root != NULL && (const void*)item < root) {
+            return FLEXB_CORRUPTED;
+        }
+        int cmp = n ? strncmp(item, key, n) : strcmp(item, key);
+        if (cmp < 0 || (upper && cmp == 0)) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *index = lo;
     return FLEXB_SUCCESS;
 }
 
-inline int flexb_vec_get_ref(const void* root, const FLEXB_vec *vec, size_t index, FLEXB_ref* ref) {
+static inline int flexb_map_lower_bound(const void* root, const FLEXB_map *map, const char* key, size_t *index) {
+    if (map == NULL || key == NULL || index == NULL) {
+        return EINVAL;
+    }
+    return _flexb_map_bound(root, map, key, 0, 0, index);
+}
+
+static inline int flexb_map_upper_bound(const void* root, const FLEXB_map *map, const char* key, size_t *index) {
+    if (map == NULL || key == NULL || index == NULL) {
+        return EINVAL;
+    }
+    return _flexb_map_bound(root, map, key, 0, 1, index);
+}
+
+/* Iterate over the keys in [low, high), a NULL bound leaves that side open. */
+static inline int flexb_map_range(const void* root, const FLEXB_map *map, const char* low, const char* high, FLEXB_map_iter *iter) {
+    if (map == NULL || iter == NULL) {
+        return EINVAL;
+    }
+    int rc;
+    iter->map = map;
+    iter->index = 0;
+    iter->end = map->keys.length;
+    if (low != NULL && (rc = _flexb_map_bound(root, map, low, 0, 0, &iter->index)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    if (high != NULL && (rc = _flexb_map_bound(root, map, high, 0, 0, &iter->end)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    if (iter->end < iter->index) {
+        iter->end = iter->index;
+    }
+    return FLEXB_SUCCESS;
+}
+
+/* Iterate over the keys starting with prefix. */
+static inline int flexb_map_prefix(const void* root, const FLEXB_map *map, const char* prefix, FLEXB_map_iter *iter) {
+    if (map == NULL || prefix == NULL || iter == NULL) {
+        return EINVAL;
+    }
+    size_t length = strlen(prefix);
+    int rc;
+    iter->map = map;
+    iter->index = 0;
+    iter->end = map->keys.length;
+    if (length == 0) {
+        return FLEXB_SUCCESS;
+    }
+    if ((rc = _flexb_map_bound(root, map, prefix, length, 0, &iter->index)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    return _flexb_map_bound(root, map, prefix, length, 1, &iter->end);
+}
+
+static inline int flexb_map_next(const void* root, FLEXB_map_iter *iter, const char** key, FLEXB_ref* ref) {
+    if (iter == NULL || ref == NULL) {
+        return EINVAL;
+    }
+    if (iter->index >= iter->end) {
+        return FLEXB_NOT_FOUND;
+    }
+    return flexb_map_get_at(root, iter->map, iter->index++, key, ref);
+}
+
+static inline int flexb_vec_get_ref(const void* root, const FLEXB_vec *vec, size_t index, FLEXB_ref* ref) {
     if (vec == NULL || ref == NULL) {
         return EINVAL;
     }
@@ -451,71 +566,71 @@ inline int flexb_vec_get_ref(const void* root, const FLEXB_vec *vec, size_t inde
     }
     uint8_t packed_byte = 0;
     if (vec->type == 0) {
-        packed_byte = *(const uint8_t*)(vec->data + (vec->byte_width * vec->length) + index);
+        packed_byte = *((const uint8_t*)vec->data + (vec->byte_width * vec->length) + index);
     } else {
         packed_byte = vec->type;
     }
-    SET_REF(ref, vec->data + (vec->byte_width * index), vec->byte_width, packed_byte);
+    SET_REF(ref, (const uint8_t*)vec->data + (vec->byte_width * index), vec->byte_width, packed_byte);
     return FLEXB_SUCCESS;
 }
 
-inline int flexb_mapsize(const void* root, const FLEXB_map* map, uint64_t* num) {
+static inline int flexb_mapsize(const void* root, const FLEXB_map* map, uint64_t* num) {
     *num = map->values.length;
     return FLEXB_SUCCESS;
 }
 
-inline int flexb_is_null(const FLEXB_ref* ref) {
+static inline int flexb_is_null(const FLEXB_ref* ref) {
     return ref != NULL && ref->type == FLEXB_NULL;
 }
 
-inline int flexb_is_int(const FLEXB_ref* ref) {
+static inline int flexb_is_int(const FLEXB_ref* ref) {
     return ref != NULL && (ref->type <= FLEXB_INT || ref->type == FLEXB_INDIRECT_INT);
 }
 
-inline int flexb_is_uint(const FLEXB_ref* ref) {
+static inline int flexb_is_uint(const FLEXB_ref* ref) {
     return ref != NULL && (ref->type <= FLEXB_UINT || ref->type == FLEXB_INDIRECT_UINT);
 }
 
-inline int flexb_is_float(const FLEXB_ref* ref) {
+static inline int flexb_is_float(const FLEXB_ref* ref) {
     return ref != NULL && (ref->type <= FLEXB_FLOAT || ref->type == FLEXB_INDIRECT_FLOAT);
 }
 
-inline int flexb_is_numeric(const FLEXB_ref* ref) {
+static inline int flexb_is_numeric(const FLEXB_ref* ref) {
     return ref != NULL && (
         (FLEXB_INT <= ref->type && ref->type <= FLEXB_FLOAT) ||
         (FLEXB_INDIRECT_INT <= ref->type && ref->type <= FLEXB_INDIRECT_FLOAT)
     );
 }
 
-inline int flexb_is_key(const FLEXB_ref* ref) {
+static inline int flexb_is_key(const FLEXB_ref* ref) {
     return ref != NULL && ref->type == FLEXB_KEY;
 }
 
-inline int flexb_is_string(const FLEXB_ref* ref) {
+static inline int flexb_is_string(const FLEXB_ref* ref) {
     return ref != NULL && ref->type == FLEXB_STRING;
 }
 
-inline int flexb_is_map(const FLEXB_ref* ref) {
+static inline int flexb_is_map(const FLEXB_ref* ref) {
     return ref != NULL && ref->type == FLEXB_MAP;
 }
 
-inline int flexb_is_vector(const FLEXB_ref* ref) {
+static inline int flexb_is_vector(const FLEXB_ref* ref) {
     return ref != NULL && ((FLEXB_MAP <= ref->type && ref->type <= FLEXB_VECTOR_FLOAT4) || ref->type == FLEXB_VECTOR_BOOL);
 }
 
-inline int flexb_is_typed_vector(const FLEXB_ref* ref) {
+static inline int flexb_is_typed_vector(const FLEXB_ref* ref) {
     return ref != NULL && ((FLEXB_VECTOR_INT <= ref->type && ref->type <= FLEXB_VECTOR_FLOAT4) || ref->type == FLEXB_VECTOR_BOOL);
 }
 
-inline int flexb_is_fixed_typed_vector(const FLEXB_ref* ref) {
+static inline int flexb_is_fixed_typed_vector(const FLEXB_ref* ref) {
     return ref != NULL && (FLEXB_VECTOR_INT2 <= ref->type && ref->type <= FLEXB_VECTOR_FLOAT4);
 }
 
-inline int flexb_is_blob(const FLEXB_ref* ref) {
+static inline int flexb_is_blob(const FLEXB_ref* ref) {
     return ref != NULL && ref->type == FLEXB_BLOB;
 }
 
-inline int flexb_is_bool(const FLEXB_ref* ref) {
+static inline int flexb_is_bool(const FLEXB_ref* ref) {
     return ref != NULL && ref->type == FLEXB_BOOL;
 }
 
@@ -0,0 +1,375 @@
+#ifndef __FLEXB_BIND__
+#define __FLEXB_BIND__
+
+#include <stddef.h>
+#include "flexb.h"
+
+/*
+ * Declarative decoding of a map into a struct.
+ *
+ * Fields are described once with an X-macro list, keys in strcmp order:
+ *
+ *   #define PERSON_FIELDS(X, T) \
+ *       X(T, "age",  age,  FLEXB_FIELD_INT) \
+ *       X(T, "name", name, FLEXB_FIELD_STR)
+ *
+ *   FLEXB_FIELDS(person_fields, struct person, PERSON_FIELDS);
+ *   FLEXB_FIELD_BITS(PERSON, PERSON_FIELDS);    // PERSON_age, PERSON_name, PERSON_COUNT
+ *
+ *   flexb_map_bind(root, &map, person_fields, PERSON_COUNT, &person, &missing, &invalid);
+ *   if (missing & FLEXB_FIELD_BIT(PERSON_age)) ...
+ *
+ * flexb_map_bind walks the map keys and the fields together in one pass,
+ * galloping over the keys between two fields.
+ * Integer members may be any size, values that do not fit are invalid.
+ *
+ * In C++ the kind is deduced from the member type and the table is tied to
+ * the struct, binding it to another type does not compile:
+ *
+ *   static const auto person_fields = flexb::make_fields(
+ *       FLEXB_BIND_MEMBER(person, "age", age),
+ *       FLEXB_BIND_MEMBER(person, "name", name));
+ *
+ *   flexb::map_bind(root, map, person_fields, person, missing, invalid);
+ */
+
+#define FLEXB_FIELD_INT   1     // int8_t to int64_t
+#define FLEXB_FIELD_UINT  2     // uint8_t to uint64_t
+#define FLEXB_FIELD_FLOAT 3     // float or double
+#define FLEXB_FIELD_BOOL  4     // Any integer member, stores 0 or 1
+#define FLEXB_FIELD_STR   5     // const char *
+#define FLEXB_FIELD_REF   6     // FLEXB_ref
+#define FLEXB_FIELD_VEC   7     // FLEXB_vec
+#define FLEXB_FIELD_MAP   8     // FLEXB_map
+
+#define FLEXB_FIELD_MAX 64
+
+#define FLEXB_FIELD(T, KEY, MEMBER, KIND) { (KEY), offsetof(T, MEMBER), sizeof(((T*)0)->MEMBER), (KIND) },
+#define FLEXB_FIELDS(NAME, T, LIST) static const FLEXB_field NAME[] = { LIST(FLEXB_FIELD, T) }
+
+#define _FLEXB_FIELD_INDEX(PREFIX, KEY, MEMBER, KIND) PREFIX##_##MEMBER,
+#define FLEXB_FIELD_BITS(PREFIX, LIST) enum { LIST(_FLEXB_FIELD_INDEX, PREFIX) PREFIX##_COUNT }
+#define FLEXB_FIELD_BIT(INDEX) (1ULL << (INDEX))
+
+typedef struct FLEXB_field {
+    const char * key;
+    size_t offset;
+    size_t size;
+    uint8_t kind;
+} FLEXB_field;
+
+static inline int _flexb_bind_int(void* dest, size_t size, int64_t num) {
+    switch (size) {
+    case 1:
+        {
+            int8_t tmp = (int8_t)num;
+            if (tmp != num) {
+                return FLEXB_INVALID_CONVERSION;
+            }
+            memcpy(dest, &tmp, 1);
+        }
+        break;
+    case 2:
+        {
+            int16_t tmp = (int16_t)num;
+            if (tmp != num) {
+                return FLEXB_INVALID_CONVERSION;
+            }
+            memcpy(dest, &tmp, 2);
+        }
+        break;
+    case 4:
+        {
+            int32_t tmp = (int32_t)num;
+            if (tmp != num) {
+                return FLEXB_INVALID_CONVERSION;
+            }
+            memcpy(dest, &tmp, 4);
+        }
+        break;
+    case 8:
+        memcpy(dest, &num, 8);
+        break;
+    default:
+        return EINVAL;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_bind_uint(void* dest, size_t size, uint64_t num) {
+    switch (size) {
+    case 1:
+        {
+            uint8_t tmp = (uint8_t)num;
+            if (tmp != num) {
+                return FLEXB_INVALID_CONVERSION;
+            }
+            memcpy(dest, &tmp, 1);
+        }
+        break;
+    case 2:
+        {
+            uint16_t tmp = (uint16_t)num;
+            if (tmp != num) {
+                return FLEXB_INVALID_CONVERSION;
+            }
+            memcpy(dest, &tmp, 2);
+        }
+        break;
+    case 4:
+        {
+            uint32_t tmp = (uint32_t)num;
+            if (tmp != num) {
+                return FLEXB_INVALID_CONVERSION;
+            }
+            memcpy(dest, &tmp, 4);
+        }
+        break;
+    case 8:
+        memcpy(dest, &num, 8);
+        break;
+    default:
+        return EINVAL;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_bind_field(const void* root, FLEXB_ref* ref, const FLEXB_field* field, void* dest) {
+    int rc = FLEXB_SUCCESS;
+    switch (field->kind) {
+    case FLEXB_FIELD_INT:
+        {
+            int64_t num;
+            if ((rc = flexb_as_int64(ref, &num)) != FLEXB_SUCCESS) {
+                break;
+            }
+            // flexb_as_int64 wraps unsigned values above INT64_MAX
+            if (num < 0 && (ref->type == FLEXB_UINT || ref->type == FLEXB_INDIRECT_UINT)) {
+                rc = FLEXB_INVALID_CONVERSION;
+                break;
+            }
+            rc = _flexb_bind_int(dest, field->size, num);
+        }
+        break;
+    case FLEXB_FIELD_UINT:
+        {
+            uint64_t num;
+            if ((rc = flexb_as_uint64(ref, &num)) != FLEXB_SUCCESS) {
+                break;
+            }
+            // flexb_as_uint64 wraps negative signed values
+            if ((int64_t)num < 0 && (ref->type == FLEXB_INT || ref->type == FLEXB_INDIRECT_INT)) {
+                rc = FLEXB_INVALID_CONVERSION;
+                break;
+            }
+            rc = _flexb_bind_uint(dest, field->size, num);
+        }
+        break;
+    case FLEXB_FIELD_FLOAT:
+        {
+            double num;
+            if (field->size != sizeof(float) && field->size != sizeof(double)) {
+                return EINVAL;
+            }
+            if ((rc = flexb_as_float((void*)root, ref, &num)) != FLEXB_SUCCESS) {
+                break;
+            }
+            if (field->size == sizeof(float)) {
+                float tmp = (float)num;
+                memcpy(dest, &tmp, sizeof(float));
+            } else {
+                memcpy(dest, &num, sizeof(double));
+            }
+        }
+        break;
+    case FLEXB_FIELD_BOOL:
+        {
+            uint64_t num = 0;
+            if (ref->type == FLEXB_BOOL) {
+                num = _flexb_get_uint64(ref->data, ref->parent_width);
+            } else if (!flexb_is_numeric(ref) || (rc = flexb_as_uint64(ref, &num)) != FLEXB_SUCCESS) {
+                rc = FLEXB_INVALID_CONVERSION;
+                break;
+            }
+            rc = _flexb_bind_uint(dest, field->size, num != 0);
+        }
+        break;
+    case FLEXB_FIELD_STR:
+        {
+            const char* str;
+            if (field->size != sizeof(const char*)) {
+                return EINVAL;
+            }
+            if ((rc = flexb_as_str(root, ref, &str)) == FLEXB_SUCCESS) {
+                memcpy(dest, &str, sizeof(const char*));
+            }
+        }
+        break;
+    case FLEXB_FIELD_REF:
+        if (field->size != sizeof(FLEXB_ref)) {
+            return EINVAL;
+        }
+        memcpy(dest, ref, sizeof(FLEXB_ref));
+        break;
+    case FLEXB_FIELD_VEC:
+        if (field->size != sizeof(FLEXB_vec)) {
+            return EINVAL;
+        }
+        rc = flexb_as_vec(root, ref, (FLEXB_vec*)dest);
+        break;
+    case FLEXB_FIELD_MAP:
+        if (field->size != sizeof(FLEXB_map)) {
+            return EINVAL;
+        }
+        rc = flexb_as_map(root, ref, (FLEXB_map*)dest);
+        break;
+    default:
+        return EINVAL;
+    }
+    return rc;
+}
+
+/*
+ * First key index >= cursor whose key is >= key. Gallops from the cursor
+ * then bisects, so a pass over F sorted fields in a map of K keys costs
+ * O(F log(K/F)) comparisons.
+ */
+static inline int _flexb_bind_seek(const void* root, const FLEXB_map* map, const char* key, size_t cursor, size_t* index, int* found) {
+    size_t lo = cursor;
+    size_t hi = cursor;
+    size_t step = 1;
+    while (hi < map->keys.length) {
+        const char* item = _flexb_map_key(map, hi);
+        if (root != NULL && (const void*)item < root) {
+            return FLEXB_CORRUPTED;
+        }
+        if (strcmp(item, key) >= 0) {
+            break;
+        }
+        lo = hi + 1;
+        hi = step < map->keys.length - hi ? hi + step : map->keys.length;
+        step *= 2;
+    }
+    // Every key before lo is smaller, the key at hi (if any) is not
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        const char* item = _flexb_map_key(map, mid);
+        if (root != NULL && (const void*)item < root) {
+            return FLEXB_CORRUPTED;
+        }
+        if (strcmp(item, key) < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    *index = lo;
+    *found = lo < map->keys.length && strcmp(_flexb_map_key(map, lo), key) == 0;
+    return FLEXB_SUCCESS;
+}
+
+/*
+ * Decode the fields found in map into out. Bit i of missing is set when
+ * fields[i].key is absent, bit i of invalid when its value could not be
+ * converted. Fields not found are left untouched.
+ */
+static inline int flexb_map_bind(const void* root, const FLEXB_map* map, const FLEXB_field* fields, size_t count, void* out, uint64_t* missing, uint64_t* invalid) {
+    if (map == NULL || fields == NULL || out == NULL || missing == NULL || invalid == NULL || count > FLEXB_FIELD_MAX) {
+        return EINVAL;
+    }
+    *missing = 0;
+    *invalid = 0;
+    size_t cursor = 0;
+    size_t i;
+    for (i = 0; i < count; i++) {
+        const FLEXB_field* field = &fields[i];
+        // Fields out of order only cost a search from the first key.
+        if (i > 0 && strcmp(fields[i - 1].key, field->key) > 0) {
+            cursor = 0;
+        }
+        int found;
+        int rc = _flexb_bind_seek(root, map, field->key, cursor, &cursor, &found);
+        if (rc != FLEXB_SUCCESS) {
+            return rc;
+        }
+        if (!found) {
+            *missing |= FLEXB_FIELD_BIT(i);
+            continue;
+        }
+        FLEXB_ref ref;
+        rc = flexb_vec_get_ref(root, &map->values, cursor, &ref);
+        if (rc == FLEXB_SUCCESS) {
+            rc = _flexb_bind_field(root, &ref, field, (uint8_t*)out + field->offset);
+        }
+        if (rc == EINVAL) {
+            return rc;
+        }
+        if (rc != FLEXB_SUCCESS) {
+            *invalid |= FLEXB_FIELD_BIT(i);
+        }
+    }
+    return FLEXB_SUCCESS;
+}
+
+#ifdef __cplusplus
+
+#include <type_traits>
+
+namespace flexb {
+
+template <typename M>
+struct field_kind {
+    static const uint8_t value =
+        std::is_same<M, bool>::value ? FLEXB_FIELD_BOOL :
+        std::is_integral<M>::value ? (std::is_signed<M>::value ? FLEXB_FIELD_INT : FLEXB_FIELD_UINT) :
+        (std::is_floating_point<M>::value && sizeof(M) <= sizeof(double)) ? FLEXB_FIELD_FLOAT : 0;
+};
+
+template <> struct field_kind<const char*> { static const uint8_t value = FLEXB_FIELD_STR; };
+template <> struct field_kind<FLEXB_ref> { static const uint8_t value = FLEXB_FIELD_REF; };
+template <> struct field_kind<FLEXB_vec> { static const uint8_t value = FLEXB_FIELD_VEC; };
+template <> struct field_kind<FLEXB_map> { static const uint8_t value = FLEXB_FIELD_MAP; };
+
+// A field of T, fields of another struct do not convert.
+template <typename T>
+struct field {
+    FLEXB_field raw;
+};
+
+template <typename T, size_t N>
+struct fields {
+    FLEXB_field items[N];
+};
+
+template <typename T, typename M>
+inline field<T> make_field(const char* key, size_t offset) {
+    static_assert(field_kind<M>::value != 0, "member type cannot be bound");
+    field<T> result = { { key, offset, sizeof(M), field_kind<M>::value } };
+    return result;
+}
+
+template <typename T>
+inline const FLEXB_field& _raw_field(const field<T>& f) {
+    return f.raw;
+}
+
+template <typename T, typename... Rest>
+inline fields<T, 1 + sizeof...(Rest)> make_fields(const field<T>& first, const Rest&... rest) {
+    fields<T, 1 + sizeof...(Rest)> result = { { first.raw, _raw_field<T>(rest)... } };
+    return result;
+}
+
+template <typename T, size_t N>
+inline int map_bind(const void* root, const FLEXB_map& map, const fields<T, N>& table, T& out, uint64_t& missing, uint64_t& invalid) {
+    static_assert(N <= FLEXB_FIELD_MAX, "too many fields for the bitmasks");
+    static_assert(std::is_standard_layout<T>::value, "fields are located with offsetof");
+    return flexb_map_bind(root, &map, table.items, N, &out, &missing, &invalid);
+}
+
+}
+
+#define FLEXB_BIND_MEMBER(T, KEY, MEMBER) flexb::make_field<T, decltype(((T*)0)->MEMBER)>((KEY), offsetof(T, MEMBER))
+
+#endif
+
+#endif
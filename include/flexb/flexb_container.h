@@ -0,0 +1,758 @@
+#ifndef __FLEXB_CONTAINER__
+#define __FLEXB_CONTAINER__
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "flexb.h"
+
+/*
+ * Container file layout:
+ *
+ *   header     { char magic[4]; uint32 version; uint64 segment }
+ *   segment 0 .. segment S-1
+ *
+ * and each segment, written by one flush, holds the records appended since
+ * the previous one followed by their index:
+ *
+ *   record i | record i+1 | ... | record i+n-1     complete FlexBuffers
+ *   offsets    uint64[n + 1]   start of each record, then the end of the last
+ *   key data   NUL terminated strings
+ *   key table  { uint64 record; uint64 key_offset }[K]   sparse index, sorted by key
+ *   trailer    { uint64 first; uint64 count; uint64 index_offset; uint64 key_count;
+ *                uint64 keys_offset; uint64 prev; uint32 version; char magic[4] }
+ *
+ * All offsets are from the start of the file, prev is the trailer of the
+ * previous segment or 0. The header points at the trailer of the last
+ * committed segment; it is rewritten in place, by one aligned 8 byte write
+ * inside the first sector, only once the segment is on disk. Nothing before
+ * the end of that segment is ever written again and the file is never
+ * truncated, so readers mapping it while a writer appends are safe, and
+ * bytes past the committed segment are a torn tail the next writer
+ * overwrites.
+ */
+
+#define FLEXB_CONTAINER_MAGIC "FXBC"
+#define FLEXB_CONTAINER_VERSION 1
+#define FLEXB_CONTAINER_HEADER_SIZE 16
+#define FLEXB_CONTAINER_TRAILER_SIZE 56
+#define FLEXB_CONTAINER_READAHEAD 64    // Records advised ahead during a scan.
+
+typedef struct FLEXB_container_segment {
+    uint64_t first;             // Index of the first record.
+    uint64_t count;
+    const uint8_t * offsets;
+    uint64_t key_first;         // Index of the first key among all segments.
+    uint64_t key_count;
+    const uint8_t * keys;
+} FLEXB_container_segment;
+
+typedef struct FLEXB_container {
+    const uint8_t * data;
+    size_t size;
+    size_t map_size;    // Non zero when the data is owned mmap.
+    size_t count;
+    size_t key_count;
+    FLEXB_container_segment * segments;
+    size_t segment_count;
+} FLEXB_container;
+
+typedef struct FLEXB_container_iter {
+    const FLEXB_container * container;
+    size_t index;
+    size_t advised;     // Records before this one have been advised.
+    size_t segment;
+} FLEXB_container_iter;
+
+typedef struct FLEXB_container_writer {
+    int fd;
+    uint64_t end;       // Where the next record goes.
+    uint64_t segment;   // Trailer of the last committed segment, 0 when none.
+    uint64_t first;     // Index of the first pending record.
+    uint64_t * offsets; // Start of each record appended since the last flush.
+    size_t count;
+    size_t offsets_cap;
+    char ** keys;       // Keys appended since the last flush.
+    uint64_t * key_records;
+    size_t key_count;
+    size_t keys_cap;
+    char * last_key;    // Last committed key, for the order check.
+} FLEXB_container_writer;
+
+typedef struct _FLEXB_container_trailer {
+    uint64_t first;
+    uint64_t count;
+    uint64_t index_offset;
+    uint64_t key_count;
+    uint64_t keys_offset;
+    uint64_t prev;
+} _FLEXB_container_trailer;
+
+static inline void _flexb_put_uint64(void* data, uint64_t num) {
+    memcpy(data, &num, 8);
+}
+
+static inline int _flexb_pwrite_all(int fd, const void* data, size_t length, uint64_t offset) {
+    while (length) {
+        ssize_t n = pwrite(fd, data, length, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        data = (const uint8_t*)data + n;
+        length -= n;
+        offset += n;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_pread_all(int fd, void* data, size_t length, uint64_t offset) {
+    while (length) {
+        ssize_t n = pread(fd, data, length, offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno;
+        }
+        if (n == 0) {
+            return FLEXB_CORRUPTED;
+        }
+        data = (uint8_t*)data + n;
+        length -= n;
+        offset += n;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_container_header(const uint8_t* header, uint64_t *segment) {
+    uint32_t version;
+    memcpy(&version, header + 4, 4);
+    if (memcmp(header, FLEXB_CONTAINER_MAGIC, 4) != 0 || version != FLEXB_CONTAINER_VERSION) {
+        return FLEXB_CORRUPTED;
+    }
+    *segment = _flexb_get_uint64(header + 8, 8);
+    return FLEXB_SUCCESS;
+}
+
+/* Check the trailer found at offset in a file of size bytes. */
+static inline int _flexb_container_trailer(const uint8_t* trailer, uint64_t offset, uint64_t size, _FLEXB_container_trailer *t) {
+    uint32_t version;
+    if (offset < FLEXB_CONTAINER_HEADER_SIZE || offset > size || size - offset < FLEXB_CONTAINER_TRAILER_SIZE) {
+        return FLEXB_CORRUPTED;
+    }
+    memcpy(&version, trailer + 48, 4);
+    if (memcmp(trailer + 52, FLEXB_CONTAINER_MAGIC, 4) != 0 || version != FLEXB_CONTAINER_VERSION) {
+        return FLEXB_CORRUPTED;
+    }
+    t->first = _flexb_get_uint64(trailer, 8);
+    t->count = _flexb_get_uint64(trailer + 8, 8);
+    t->index_offset = _flexb_get_uint64(trailer + 16, 8);
+    t->key_count = _flexb_get_uint64(trailer + 24, 8);
+    t->keys_offset = _flexb_get_uint64(trailer + 32, 8);
+    t->prev = _flexb_get_uint64(trailer + 40, 8);
+    if (t->index_offset < FLEXB_CONTAINER_HEADER_SIZE || t->index_offset > offset ||
+        t->count >= (offset - t->index_offset) / 8 ||
+        t->keys_offset > offset || t->keys_offset < t->index_offset + (t->count + 1) * 8 ||
+        (offset - t->keys_offset) % 16 != 0 || t->key_count != (offset - t->keys_offset) / 16 ||
+        (t->prev != 0 && (t->prev < FLEXB_CONTAINER_HEADER_SIZE || t->prev + FLEXB_CONTAINER_TRAILER_SIZE > t->index_offset))) {
+        return FLEXB_CORRUPTED;
+    }
+    return FLEXB_SUCCESS;
+}
+
+/*
+ * Check the sparse key table of a segment, index points at the byte found at
+ * index_offset in the file. Every key must be a string of the key data
+ * referring to a record of the segment.
+ */
+static inline int _flexb_container_check_keys(const uint8_t* index, const _FLEXB_container_trailer *t) {
+    const uint8_t* table = index + (t->keys_offset - t->index_offset);
+    uint64_t key_data = t->index_offset + (t->count + 1) * 8;
+    size_t i;
+    for (i = 0; i < t->key_count; i++) {
+        uint64_t record = _flexb_get_uint64(table + i * 16, 8);
+        uint64_t key_offset = _flexb_get_uint64(table + i * 16 + 8, 8);
+        if (record < t->first || record - t->first >= t->count ||
+            key_offset < key_data || key_offset >= t->keys_offset ||
+            memchr(index + (key_offset - t->index_offset), 0, t->keys_offset - key_offset) == NULL) {
+            return FLEXB_CORRUPTED;
+        }
+    }
+    return FLEXB_SUCCESS;
+}
+
+/* Walk the segments back from the committed one and build the directory. */
+static inline int _flexb_container_load(const uint8_t* data, size_t size, uint64_t segment, FLEXB_container *c) {
+    FLEXB_container_segment* segments = NULL;
+    size_t segment_count = 0;
+    size_t cap = 0;
+    uint64_t next_first = 0;
+    int rc = FLEXB_SUCCESS;
+    while (segment != 0) {
+        _FLEXB_container_trailer t;
+        rc = _flexb_container_trailer(data + segment, segment, size, &t);
+        if (rc == FLEXB_SUCCESS && segment_count && t.first + t.count != next_first) {
+            rc = FLEXB_CORRUPTED;
+        }
+        if (rc == FLEXB_SUCCESS) {
+            rc = _flexb_container_check_keys(data + t.index_offset, &t);
+        }
+        if (rc == FLEXB_SUCCESS && segment_count == cap) {
+            cap = cap ? cap * 2 : 16;
+            FLEXB_container_segment* grown = realloc(segments, cap * sizeof(FLEXB_container_segment));
+            if (grown == NULL) {
+                rc = ENOMEM;
+            } else {
+                segments = grown;
+            }
+        }
+        if (rc != FLEXB_SUCCESS) {
+            free(segments);
+            return rc;
+        }
+        FLEXB_container_segment* seg = &segments[segment_count++];
+        seg->first = t.first;
+        seg->count = t.count;
+        seg->offsets = data + t.index_offset;
+        seg->key_count = t.key_count;
+        seg->keys = data + t.keys_offset;
+        next_first = t.first;
+        segment = t.prev;
+    }
+    if (next_first != 0) {
+        free(segments);
+        return FLEXB_CORRUPTED;
+    }
+    // Collected newest first
+    size_t i;
+    uint64_t key_first = 0;
+    for (i = 0; i < segment_count / 2; i++) {
+        FLEXB_container_segment tmp = segments[i];
+        segments[i] = segments[segment_count - 1 - i];
+        segments[segment_count - 1 - i] = tmp;
+    }
+    for (i = 0; i < segment_count; i++) {
+        segments[i].key_first = key_first;
+        key_first += segments[i].key_count;
+    }
+    c->data = data;
+    c->size = size;
+    c->map_size = 0;
+    c->count = segment_count ? segments[segment_count - 1].first + segments[segment_count - 1].count : 0;
+    c->key_count = key_first;
+    c->segments = segments;
+    c->segment_count = segment_count;
+    return FLEXB_SUCCESS;
+}
+
+/*
+ * Read a container held in memory, the segment committed in its header is
+ * used and anything after it ignored. Release with flexb_container_close.
+ */
+static inline int flexb_container_init(const void* data, size_t size, FLEXB_container *c) {
+    if (data == NULL || c == NULL) {
+        return EINVAL;
+    }
+    uint64_t segment;
+    if (size < FLEXB_CONTAINER_HEADER_SIZE || _flexb_container_header(data, &segment) != FLEXB_SUCCESS) {
+        return FLEXB_CORRUPTED;
+    }
+    return _flexb_container_load(data, size, segment, c);
+}
+
+static inline int flexb_container_open(const char* path, FLEXB_container *c) {
+    if (path == NULL || c == NULL) {
+        return EINVAL;
+    }
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return errno;
+    }
+    // The header is read before the size so the segment it names is within
+    // the mapping, a writer may commit a later one at any time.
+    uint8_t header[FLEXB_CONTAINER_HEADER_SIZE];
+    uint64_t segment;
+    struct stat st;
+    int rc = _flexb_pread_all(fd, header, sizeof(header), 0);
+    if (rc == FLEXB_SUCCESS) {
+        rc = _flexb_container_header(header, &segment);
+    }
+    if (rc == FLEXB_SUCCESS && fstat(fd, &st) != 0) {
+        rc = errno;
+    }
+    if (rc != FLEXB_SUCCESS) {
+        close(fd);
+        return rc;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return errno;
+    }
+    rc = _flexb_container_load(data, st.st_size, segment, c);
+    if (rc != FLEXB_SUCCESS) {
+        munmap(data, st.st_size);
+        return rc;
+    }
+    c->map_size = st.st_size;
+    return FLEXB_SUCCESS;
+}
+
+static inline void flexb_container_close(FLEXB_container *c) {
+    if (c == NULL) {
+        return;
+    }
+    free(c->segments);
+    c->segments = NULL;
+    c->segment_count = 0;
+    if (c->map_size) {
+        munmap((void*)c->data, c->map_size);
+        c->map_size = 0;
+    }
+}
+
+/* Segment holding record index, hint is tried first. */
+static inline size_t _flexb_container_find(const FLEXB_container *c, size_t index, size_t hint) {
+    const FLEXB_container_segment* seg = c->segments;
+    if (hint < c->segment_count && seg[hint].first <= index) {
+        if (index - seg[hint].first < seg[hint].count) {
+            return hint;
+        }
+        if (hint + 1 < c->segment_count && index - seg[hint + 1].first < seg[hint + 1].count) {
+            return hint + 1;
+        }
+    }
+    size_t lo = 0;
+    size_t hi = c->segment_count;
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (seg[mid].first <= index) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static inline int _flexb_container_span(const FLEXB_container *c, size_t segment, size_t index, uint64_t *start, uint64_t *end) {
+    const FLEXB_container_segment* seg = &c->segments[segment];
+    size_t i = index - seg->first;
+    *start = _flexb_get_uint64(seg->offsets + i * 8, 8);
+    *end = _flexb_get_uint64(seg->offsets + i * 8 + 8, 8);
+    if (*start < FLEXB_CONTAINER_HEADER_SIZE || *start > *end || *end > (uint64_t)(seg->offsets - c->data)) {
+        return FLEXB_CORRUPTED;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_container_get(const FLEXB_container *c, size_t segment, size_t index, FLEXB_root *root, FLEXB_ref* ref) {
+    uint64_t start, end;
+    int rc = _flexb_container_span(c, segment, index, &start, &end);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    return flexb_set_root(c->data + start, end - start, root, ref);
+}
+
+/* Read record index, a bisect over the segments, one per flush. */
+static inline int flexb_container_get(const FLEXB_container *c, size_t index, FLEXB_root *root, FLEXB_ref* ref) {
+    if (c == NULL || ref == NULL) {
+        return EINVAL;
+    }
+    if (index >= c->count) {
+        return FLEXB_NOT_FOUND;
+    }
+    return _flexb_container_get(c, _flexb_container_find(c, index, c->segment_count), index, root, ref);
+}
+
+/* Key number index among all segments, and the record it refers to. */
+static inline const char * _flexb_container_key(const FLEXB_container *c, size_t index, uint64_t *record) {
+    const FLEXB_container_segment* seg = c->segments;
+    size_t lo = 0;
+    size_t hi = c->segment_count;
+    // The last segment starting at or before index holds it, segments
+    // without keys are followed by one with the same key_first.
+    while (hi - lo > 1) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (seg[mid].key_first <= index) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+    const uint8_t* entry = seg[lo].keys + (index - seg[lo].key_first) * 16;
+    *record = _flexb_get_uint64(entry, 8);
+    return (const char*)c->data + _flexb_get_uint64(entry + 8, 8);
+}
+
+/*
+ * Find the last record indexed with a key <= key, the place to start a scan
+ * for key when records were appended in key order.
+ */
+static inline int flexb_container_seek(const FLEXB_container *c, const char* key, size_t *index) {
+    if (c == NULL || key == NULL || index == NULL) {
+        return EINVAL;
+    }
+    uint64_t record;
+    size_t lo = 0;
+    size_t hi = c->key_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (strcmp(_flexb_container_key(c, mid, &record), key) <= 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return FLEXB_NOT_FOUND;
+    }
+    _flexb_container_key(c, lo - 1, &record);
+    *index = record;
+    return FLEXB_SUCCESS;
+}
+
+static inline void _flexb_container_advise(const FLEXB_container *c, size_t first, size_t last, int advice) {
+    uint64_t start, end, tmp;
+    if (!c->map_size || first >= last ||
+        _flexb_container_span(c, _flexb_container_find(c, first, c->segment_count), first, &start, &tmp) != FLEXB_SUCCESS ||
+        _flexb_container_span(c, _flexb_container_find(c, last - 1, c->segment_count), last - 1, &tmp, &end) != FLEXB_SUCCESS ||
+        start >= end) {
+        return;
+    }
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t from = (uintptr_t)(c->data + start) & ~(page - 1);
+    madvise((void*)from, (uintptr_t)(c->data + end) - from, advice);
+}
+
+/* Advise the window after the advised records, once half of the last one is read. */
+static inline void _flexb_container_readahead(FLEXB_container_iter *iter) {
+    const FLEXB_container* c = iter->container;
+    if (iter->advised >= c->count || iter->index + FLEXB_CONTAINER_READAHEAD / 2 < iter->advised) {
+        return;
+    }
+    size_t first = iter->advised > iter->index ? iter->advised : iter->index;
+    size_t last = first + FLEXB_CONTAINER_READAHEAD;
+    if (last > c->count) {
+        last = c->count;
+    }
+    _flexb_container_advise(c, first, last, MADV_WILLNEED);
+    iter->advised = last;
+}
+
+static inline int flexb_container_iter_init(const FLEXB_container *c, size_t first, FLEXB_container_iter *iter) {
+    if (c == NULL || iter == NULL) {
+        return EINVAL;
+    }
+    iter->container = c;
+    iter->index = first;
+    iter->advised = first;
+    iter->segment = c->segment_count;
+    _flexb_container_advise(c, first < c->count ? first : c->count, c->count, MADV_SEQUENTIAL);
+    _flexb_container_readahead(iter);
+    return FLEXB_SUCCESS;
+}
+
+static inline int flexb_container_next(FLEXB_container_iter *iter, FLEXB_root *root, FLEXB_ref* ref) {
+    if (iter == NULL || ref == NULL) {
+        return EINVAL;
+    }
+    const FLEXB_container* c = iter->container;
+    if (iter->index >= c->count) {
+        return FLEXB_NOT_FOUND;
+    }
+    _flexb_container_readahead(iter);
+    iter->segment = _flexb_container_find(c, iter->index, iter->segment);
+    return _flexb_container_get(c, iter->segment, iter->index++, root, ref);
+}
+
+static inline int _flexb_container_push_key(FLEXB_container_writer *w, const char* key, uint64_t record) {
+    const char* last = w->key_count ? w->keys[w->key_count - 1] : w->last_key;
+    if (last != NULL && strcmp(last, key) > 0) {
+        return EINVAL;
+    }
+    if (w->key_count == w->keys_cap) {
+        size_t cap = w->keys_cap ? w->keys_cap * 2 : 16;
+        char** keys = realloc(w->keys, cap * sizeof(char*));
+        if (keys == NULL) {
+            return ENOMEM;
+        }
+        w->keys = keys;
+        uint64_t* records = realloc(w->key_records, cap * sizeof(uint64_t));
+        if (records == NULL) {
+            return ENOMEM;
+        }
+        w->key_records = records;
+        w->keys_cap = cap;
+    }
+    char* copy = strdup(key);
+    if (copy == NULL) {
+        return ENOMEM;
+    }
+    w->keys[w->key_count] = copy;
+    w->key_records[w->key_count++] = record;
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_container_push_offset(FLEXB_container_writer *w, uint64_t start) {
+    if (w->count == w->offsets_cap) {
+        size_t cap = w->offsets_cap ? w->offsets_cap * 2 : 64;
+        uint64_t* offsets = realloc(w->offsets, cap * sizeof(uint64_t));
+        if (offsets == NULL) {
+            return ENOMEM;
+        }
+        w->offsets = offsets;
+        w->offsets_cap = cap;
+    }
+    w->offsets[w->count++] = start;
+    return FLEXB_SUCCESS;
+}
+
+static inline void _flexb_container_writer_free(FLEXB_container_writer *w) {
+    size_t i;
+    for (i = 0; i < w->key_count; i++) {
+        free(w->keys[i]);
+    }
+    free(w->keys);
+    free(w->key_records);
+    free(w->offsets);
+    free(w->last_key);
+    w->keys = NULL;
+    w->key_records = NULL;
+    w->offsets = NULL;
+    w->last_key = NULL;
+    w->count = w->key_count = w->keys_cap = w->offsets_cap = 0;
+}
+
+/*
+ * Pick up an existing container from its header. Only the segment trailers
+ * and the last key are read, new records go after the committed segment.
+ */
+static inline int _flexb_container_writer_load(FLEXB_container_writer *w, uint64_t size) {
+    uint8_t buf[FLEXB_CONTAINER_TRAILER_SIZE];
+    _FLEXB_container_trailer t;
+    uint64_t segment;
+    uint64_t next_first = 0;
+    uint64_t key_entry = 0;
+    uint64_t key_end = 0;
+    int rc = _flexb_pread_all(w->fd, buf, FLEXB_CONTAINER_HEADER_SIZE, 0);
+    if (rc == FLEXB_SUCCESS) {
+        rc = _flexb_container_header(buf, &segment);
+    }
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    w->segment = segment;
+    w->end = FLEXB_CONTAINER_HEADER_SIZE;
+    while (segment != 0) {
+        rc = _flexb_pread_all(w->fd, buf, sizeof(buf), segment);
+        if (rc == FLEXB_SUCCESS) {
+            rc = _flexb_container_trailer(buf, segment, size, &t);
+        }
+        if (rc == FLEXB_SUCCESS && segment != w->segment && t.first + t.count != next_first) {
+            rc = FLEXB_CORRUPTED;
+        }
+        if (rc != FLEXB_SUCCESS) {
+            return rc;
+        }
+        if (segment == w->segment) {
+            w->first = t.first + t.count;
+            w->end = segment + FLEXB_CONTAINER_TRAILER_SIZE;
+        }
+        if (t.key_count && !key_end) {
+            key_entry = segment - 16;
+            key_end = t.keys_offset;
+        }
+        next_first = t.first;
+        segment = t.prev;
+    }
+    if (next_first != 0) {
+        return FLEXB_CORRUPTED;
+    }
+    if (key_end) {
+        uint64_t key_offset;
+        rc = _flexb_pread_all(w->fd, buf, 16, key_entry);
+        key_offset = _flexb_get_uint64(buf + 8, 8);
+        if (rc == FLEXB_SUCCESS && (key_offset >= key_end || key_offset < FLEXB_CONTAINER_HEADER_SIZE)) {
+            rc = FLEXB_CORRUPTED;
+        }
+        if (rc == FLEXB_SUCCESS && (w->last_key = malloc(key_end - key_offset)) == NULL) {
+            rc = ENOMEM;
+        }
+        if (rc == FLEXB_SUCCESS) {
+            rc = _flexb_pread_all(w->fd, w->last_key, key_end - key_offset, key_offset);
+        }
+        if (rc == FLEXB_SUCCESS && memchr(w->last_key, 0, key_end - key_offset) == NULL) {
+            rc = FLEXB_CORRUPTED;
+        }
+    }
+    return rc;
+}
+
+/* Open or create a container for appending. */
+static inline int flexb_container_writer_open(const char* path, FLEXB_container_writer *w) {
+    if (path == NULL || w == NULL) {
+        return EINVAL;
+    }
+    memset(w, 0, sizeof(*w));
+    w->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (w->fd < 0) {
+        return errno;
+    }
+    struct stat st;
+    int rc = FLEXB_SUCCESS;
+    if (fstat(w->fd, &st) != 0) {
+        rc = errno;
+    } else if (st.st_size >= FLEXB_CONTAINER_HEADER_SIZE) {
+        rc = _flexb_container_writer_load(w, st.st_size);
+    } else {
+        // New file, or one that died before its header was complete
+        uint8_t header[FLEXB_CONTAINER_HEADER_SIZE] = {0};
+        uint32_t version = FLEXB_CONTAINER_VERSION;
+        memcpy(header, FLEXB_CONTAINER_MAGIC, 4);
+        memcpy(header + 4, &version, 4);
+        rc = _flexb_pwrite_all(w->fd, header, sizeof(header), 0);
+        if (rc == FLEXB_SUCCESS && fdatasync(w->fd) != 0) {
+            rc = errno;
+        }
+        w->end = FLEXB_CONTAINER_HEADER_SIZE;
+    }
+    if (rc != FLEXB_SUCCESS) {
+        _flexb_container_writer_free(w);
+        close(w->fd);
+        w->fd = -1;
+    }
+    return rc;
+}
+
+/*
+ * Append one FlexBuffer. key is optional, records given a key are added to the
+ * sparse key index and their keys must not decrease.
+ */
+static inline int flexb_container_append(FLEXB_container_writer *w, const void* data, size_t length, const char* key) {
+    if (w == NULL || data == NULL || w->fd < 0) {
+        return EINVAL;
+    }
+    int rc;
+    if (key != NULL) {
+        rc = _flexb_container_push_key(w, key, w->first + w->count);
+        if (rc != FLEXB_SUCCESS) {
+            return rc;
+        }
+    }
+    rc = _flexb_pwrite_all(w->fd, data, length, w->end);
+    if (rc == FLEXB_SUCCESS) {
+        rc = _flexb_container_push_offset(w, w->end);
+    }
+    if (rc != FLEXB_SUCCESS) {
+        if (key != NULL) {
+            free(w->keys[--w->key_count]);
+        }
+        return rc;
+    }
+    w->end += length;
+    return FLEXB_SUCCESS;
+}
+
+/*
+ * Write a segment indexing the records appended since the last flush, then
+ * commit it in the header. Records and segment are synced first so the
+ * header never names data that is not on disk.
+ */
+static inline int flexb_container_writer_flush(FLEXB_container_writer *w) {
+    if (w == NULL || w->fd < 0) {
+        return EINVAL;
+    }
+    if (w->count == 0) {
+        return FLEXB_SUCCESS;
+    }
+    size_t keys_length = 0;
+    size_t i;
+    for (i = 0; i < w->key_count; i++) {
+        keys_length += strlen(w->keys[i]) + 1;
+    }
+    size_t length = (w->count + 1) * 8 + keys_length + w->key_count * 16 + FLEXB_CONTAINER_TRAILER_SIZE;
+    uint8_t* footer = malloc(length);
+    if (footer == NULL) {
+        return ENOMEM;
+    }
+    uint8_t* p = footer;
+    for (i = 0; i < w->count; i++, p += 8) {
+        _flexb_put_uint64(p, w->offsets[i]);
+    }
+    _flexb_put_uint64(p, w->end);
+    p += 8;
+    uint8_t* key_data = p;
+    for (i = 0; i < w->key_count; i++) {
+        size_t key_length = strlen(w->keys[i]) + 1;
+        memcpy(p, w->keys[i], key_length);
+        p += key_length;
+    }
+    uint64_t keys_offset = w->end + (p - footer);
+    uint64_t key_offset = w->end + (key_data - footer);
+    for (i = 0; i < w->key_count; i++, p += 16) {
+        _flexb_put_uint64(p, w->key_records[i]);
+        _flexb_put_uint64(p + 8, key_offset);
+        key_offset += strlen(w->keys[i]) + 1;
+    }
+    uint64_t segment = w->end + (p - footer);
+    uint32_t version = FLEXB_CONTAINER_VERSION;
+    _flexb_put_uint64(p, w->first);
+    _flexb_put_uint64(p + 8, w->count);
+    _flexb_put_uint64(p + 16, w->end);
+    _flexb_put_uint64(p + 24, w->key_count);
+    _flexb_put_uint64(p + 32, keys_offset);
+    _flexb_put_uint64(p + 40, w->segment);
+    memcpy(p + 48, &version, 4);
+    memcpy(p + 52, FLEXB_CONTAINER_MAGIC, 4);
+    int rc = _flexb_pwrite_all(w->fd, footer, length, w->end);
+    free(footer);
+    if (rc == FLEXB_SUCCESS && fdatasync(w->fd) != 0) {
+        rc = errno;
+    }
+    uint8_t pointer[8];
+    _flexb_put_uint64(pointer, segment);
+    if (rc == FLEXB_SUCCESS) {
+        rc = _flexb_pwrite_all(w->fd, pointer, 8, 8);
+    }
+    if (rc == FLEXB_SUCCESS && fdatasync(w->fd) != 0) {
+        rc = errno;
+    }
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    // Only the last key is kept, for the order check
+    if (w->key_count) {
+        free(w->last_key);
+        w->last_key = w->keys[--w->key_count];
+        for (i = 0; i < w->key_count; i++) {
+            free(w->keys[i]);
+        }
+        w->key_count = 0;
+    }
+    w->segment = segment;
+    w->first += w->count;
+    w->count = 0;
+    w->end += length;
+    return FLEXB_SUCCESS;
+}
+
+static inline int flexb_container_writer_close(FLEXB_container_writer *w) {
+    if (w == NULL || w->fd < 0) {
+        return EINVAL;
+    }
+    int rc = flexb_container_writer_flush(w);
+    if (close(w->fd) != 0 && rc == FLEXB_SUCCESS) {
+        rc = errno;
+    }
+    w->fd = -1;
+    _flexb_container_writer_free(w);
+    return rc;
+}
+
+#endif
@@ -0,0 +1,538 @@
+#ifndef __FLEXB_STREAM__
+#define __FLEXB_STREAM__
+
+#include <unistd.h>
+#include "flexb.h"
+
+/*
+ * Streaming builder.
+ *
+ * FlexBuffers only reference backwards, so strings, blobs and containers are
+ * written out as soon as they are finished and only go through a fixed size
+ * buffer on their way to the fd. What stays in memory is the stack of values
+ * still waiting for their parent container to be closed.
+ *
+ *   flexb_stream_start_map(s);
+ *   flexb_stream_key(s, "name");
+ *   flexb_stream_string(s, "Fred");
+ *   flexb_stream_end_map(s);
+ *   flexb_stream_finish(s);
+ */
+
+#define FLEXB_STREAM_BUFFER_SIZE 65536
+
+typedef struct _FLEXB_value {
+    union {
+        int64_t i;
+        uint64_t u;
+        double f;
+    } v;
+    char * key;         // Copy of a map key, needed to sort the map on close.
+    uint8_t type;
+    uint8_t min_width;  // Bit width: 0 for 8 bits up to 3 for 64 bits.
+} _FLEXB_value;
+
+typedef struct _FLEXB_stream_open {
+    size_t start;
+    uint8_t is_map;
+} _FLEXB_stream_open;
+
+typedef struct FLEXB_stream {
+    int fd;
+    int error;
+    uint64_t flushed;
+    uint8_t * buf;
+    size_t buf_len;
+    size_t buf_cap;
+    _FLEXB_value * stack;
+    size_t stack_len;
+    size_t stack_cap;
+    _FLEXB_stream_open * open;
+    size_t open_len;
+    size_t open_cap;
+} FLEXB_stream;
+
+static inline uint8_t _flexb_width_u(uint64_t u) {
+    if (!(u & ~0xffULL)) {
+        return 0;
+    }
+    if (!(u & ~0xffffULL)) {
+        return 1;
+    }
+    if (!(u & ~0xffffffffULL)) {
+        return 2;
+    }
+    return 3;
+}
+
+static inline uint8_t _flexb_width_i(int64_t i) {
+    uint64_t u = (uint64_t)i << 1;
+    return _flexb_width_u(i >= 0 ? u : ~u);
+}
+
+static inline int _flexb_is_inline(uint8_t type) {
+    return type <= FLEXB_FLOAT || type == FLEXB_BOOL;
+}
+
+static inline uint64_t _flexb_stream_size(const FLEXB_stream *s) {
+    return s->flushed + s->buf_len;
+}
+
+static inline int _flexb_stream_flush(FLEXB_stream *s) {
+    const uint8_t* data = s->buf;
+    while (s->buf_len) {
+        ssize_t n = write(s->fd, data, s->buf_len);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return s->error = errno;
+        }
+        data += n;
+        s->buf_len -= n;
+        s->flushed += n;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_stream_write(FLEXB_stream *s, const void* data, size_t length) {
+    if (length > s->buf_cap - s->buf_len) {
+        int rc = _flexb_stream_flush(s);
+        if (rc != FLEXB_SUCCESS) {
+            return rc;
+        }
+    }
+    if (length < s->buf_cap) {
+        memcpy(s->buf + s->buf_len, data, length);
+        s->buf_len += length;
+        return FLEXB_SUCCESS;
+    }
+    // Larger than the whole buffer, bypass it.
+    while (length) {
+        ssize_t n = write(s->fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return s->error = errno;
+        }
+        data = (const uint8_t*)data + n;
+        length -= n;
+        s->flushed += n;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_stream_write_uint(FLEXB_stream *s, uint64_t num, uint8_t byte_width) {
+    return _flexb_stream_write(s, &num, byte_width);
+}
+
+static inline int _flexb_stream_write_float(FLEXB_stream *s, double num, uint8_t byte_width) {
+    if (byte_width == 4) {
+        float tmp = (float)num;
+        return _flexb_stream_write(s, &tmp, 4);
+    }
+    return _flexb_stream_write(s, &num, 8);
+}
+
+static inline uint8_t _flexb_padding(uint64_t size, uint8_t byte_width) {
+    return (uint8_t)(-size & (byte_width - 1));
+}
+
+static inline int _flexb_stream_align(FLEXB_stream *s, uint8_t bit_width, uint8_t *byte_width) {
+    static const uint8_t zeros[8] = {0};
+    *byte_width = 1 << bit_width;
+    return _flexb_stream_write(s, zeros, _flexb_padding(_flexb_stream_size(s), *byte_width));
+}
+
+/* Bit width needed to store value as element index of a vector starting at the current size. */
+static inline uint8_t _flexb_elem_width(const _FLEXB_value* value, uint64_t size, size_t index) {
+    if (_flexb_is_inline(value->type)) {
+        return value->min_width;
+    }
+    uint8_t bit_width;
+    for (bit_width = 0; bit_width < 3; bit_width++) {
+        uint8_t byte_width = 1 << bit_width;
+        uint64_t offset_loc = size + _flexb_padding(size, byte_width) + index * byte_width;
+        if ((1 << _flexb_width_u(offset_loc - value->v.u)) <= byte_width) {
+            break;
+        }
+    }
+    return bit_width;
+}
+
+static inline uint8_t _flexb_packed_type(const _FLEXB_value* value, uint8_t parent_bit_width) {
+    uint8_t bit_width = value->min_width;
+    if (_flexb_is_inline(value->type) && parent_bit_width > bit_width) {
+        bit_width = parent_bit_width;
+    }
+    return (uint8_t)(value->type << 2) | bit_width;
+}
+
+static inline int _flexb_stream_write_any(FLEXB_stream *s, const _FLEXB_value* value, uint8_t byte_width) {
+    switch (value->type) {
+    case FLEXB_NULL:
+    case FLEXB_INT:
+    case FLEXB_UINT:
+    case FLEXB_BOOL:
+        return _flexb_stream_write_uint(s, value->v.u, byte_width);
+    case FLEXB_FLOAT:
+        return _flexb_stream_write_float(s, value->v.f, byte_width);
+    }
+    return _flexb_stream_write_uint(s, _flexb_stream_size(s) - value->v.u, byte_width);
+}
+
+static inline int _flexb_stream_grow(FLEXB_stream *s) {
+    if (s->stack_len == s->stack_cap) {
+        size_t cap = s->stack_cap ? s->stack_cap * 2 : 64;
+        _FLEXB_value* stack = realloc(s->stack, cap * sizeof(_FLEXB_value));
+        if (stack == NULL) {
+            return ENOMEM;
+        }
+        s->stack = stack;
+        s->stack_cap = cap;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline int _flexb_stream_push(FLEXB_stream *s, uint8_t type, uint8_t min_width, uint64_t num, const char* key) {
+    if (s->error) {
+        return s->error;
+    }
+    int rc = _flexb_stream_grow(s);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    _FLEXB_value* value = &s->stack[s->stack_len];
+    value->key = NULL;
+    if (key != NULL && (value->key = strdup(key)) == NULL) {
+        return ENOMEM;
+    }
+    value->v.u = num;
+    value->type = type;
+    value->min_width = min_width;
+    s->stack_len++;
+    return FLEXB_SUCCESS;
+}
+
+/* Inside a map keys and values must alternate. */
+static inline int _flexb_stream_check(const FLEXB_stream *s, int is_key) {
+    if (s->error) {
+        return s->error;
+    }
+    int in_map = s->open_len && s->open[s->open_len - 1].is_map;
+    if (!in_map) {
+        return is_key ? EINVAL : FLEXB_SUCCESS;
+    }
+    int expect_key = (s->stack_len - s->open[s->open_len - 1].start) % 2 == 0;
+    return expect_key == is_key ? FLEXB_SUCCESS : EINVAL;
+}
+
+static inline int _flexb_stream_scalar(FLEXB_stream *s, uint8_t type, uint8_t min_width, uint64_t num) {
+    int rc = _flexb_stream_check(s, 0);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    return _flexb_stream_push(s, type, min_width, num, NULL);
+}
+
+static inline int flexb_stream_init(FLEXB_stream *s, int fd, size_t buffer_size) {
+    if (s == NULL || fd < 0) {
+        return EINVAL;
+    }
+    memset(s, 0, sizeof(*s));
+    s->fd = fd;
+    s->buf_cap = buffer_size ? buffer_size : FLEXB_STREAM_BUFFER_SIZE;
+    s->buf = malloc(s->buf_cap);
+    if (s->buf == NULL) {
+        return ENOMEM;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline void flexb_stream_free(FLEXB_stream *s) {
+    if (s == NULL) {
+        return;
+    }
+    size_t i;
+    for (i = 0; i < s->stack_len; i++) {
+        free(s->stack[i].key);
+    }
+    free(s->stack);
+    free(s->open);
+    free(s->buf);
+    s->stack = NULL;
+    s->open = NULL;
+    s->buf = NULL;
+    s->stack_len = s->stack_cap = s->open_len = s->open_cap = s->buf_len = s->buf_cap = 0;
+}
+
+static inline int flexb_stream_null(FLEXB_stream *s) {
+    return _flexb_stream_scalar(s, FLEXB_NULL, 0, 0);
+}
+
+static inline int flexb_stream_int(FLEXB_stream *s, int64_t num) {
+    return _flexb_stream_scalar(s, FLEXB_INT, _flexb_width_i(num), (uint64_t)num);
+}
+
+static inline int flexb_stream_uint(FLEXB_stream *s, uint64_t num) {
+    return _flexb_stream_scalar(s, FLEXB_UINT, _flexb_width_u(num), num);
+}
+
+static inline int flexb_stream_bool(FLEXB_stream *s, int boolean) {
+    return _flexb_stream_scalar(s, FLEXB_BOOL, 0, boolean != 0);
+}
+
+static inline int flexb_stream_float(FLEXB_stream *s, double num) {
+    int rc = _flexb_stream_check(s, 0);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    rc = _flexb_stream_push(s, FLEXB_FLOAT, (double)(float)num == num ? 2 : 3, 0, NULL);
+    if (rc == FLEXB_SUCCESS) {
+        s->stack[s->stack_len - 1].v.f = num;
+    }
+    return rc;
+}
+
+static inline int _flexb_stream_sized(FLEXB_stream *s, uint8_t type, const void* data, size_t length) {
+    int rc = _flexb_stream_check(s, 0);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    uint8_t bit_width = _flexb_width_u(length);
+    uint8_t byte_width;
+    if ((rc = _flexb_stream_align(s, bit_width, &byte_width)) != FLEXB_SUCCESS ||
+        (rc = _flexb_stream_write_uint(s, length, byte_width)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    uint64_t loc = _flexb_stream_size(s);
+    if ((rc = _flexb_stream_write(s, data, length)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    if (type == FLEXB_STRING && (rc = _flexb_stream_write(s, "", 1)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    return _flexb_stream_push(s, type, bit_width, loc, NULL);
+}
+
+static inline int flexb_stream_string(FLEXB_stream *s, const char* str) {
+    if (s == NULL || str == NULL) {
+        return EINVAL;
+    }
+    return _flexb_stream_sized(s, FLEXB_STRING, str, strlen(str));
+}
+
+static inline int flexb_stream_blob(FLEXB_stream *s, const void* blob, size_t length) {
+    if (s == NULL || (blob == NULL && length)) {
+        return EINVAL;
+    }
+    return _flexb_stream_sized(s, FLEXB_BLOB, blob, length);
+}
+
+/* Key of the next value of the innermost open map. */
+static inline int flexb_stream_key(FLEXB_stream *s, const char* key) {
+    if (s == NULL || key == NULL) {
+        return EINVAL;
+    }
+    int rc = _flexb_stream_check(s, 1);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    uint64_t loc = _flexb_stream_size(s);
+    if ((rc = _flexb_stream_write(s, key, strlen(key) + 1)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    return _flexb_stream_push(s, FLEXB_KEY, 0, loc, key);
+}
+
+static inline int _flexb_stream_start(FLEXB_stream *s, uint8_t is_map) {
+    if (s == NULL) {
+        return EINVAL;
+    }
+    int rc = _flexb_stream_check(s, 0);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    if (s->open_len == s->open_cap) {
+        size_t cap = s->open_cap ? s->open_cap * 2 : 16;
+        _FLEXB_stream_open* open = realloc(s->open, cap * sizeof(_FLEXB_stream_open));
+        if (open == NULL) {
+            return ENOMEM;
+        }
+        s->open = open;
+        s->open_cap = cap;
+    }
+    s->open[s->open_len].start = s->stack_len;
+    s->open[s->open_len].is_map = is_map;
+    s->open_len++;
+    return FLEXB_SUCCESS;
+}
+
+static inline int flexb_stream_start_vector(FLEXB_stream *s) {
+    return _flexb_stream_start(s, 0);
+}
+
+static inline int flexb_stream_start_map(FLEXB_stream *s) {
+    return _flexb_stream_start(s, 1);
+}
+
+/*
+ * Write the vector of the length values found every step from start on the
+ * stack. Typed vectors carry no type bytes, maps are prefixed by their keys.
+ */
+static inline int _flexb_stream_vector(FLEXB_stream *s, size_t start, size_t length, size_t step, int typed, const _FLEXB_value* keys, _FLEXB_value* result) {
+    uint64_t size = _flexb_stream_size(s);
+    uint8_t bit_width = _flexb_width_u(length);
+    size_t prefix = 1;
+    size_t i;
+    int rc;
+    if (keys != NULL) {
+        uint8_t keys_width = _flexb_elem_width(keys, size, 0);
+        if (keys_width > bit_width) {
+            bit_width = keys_width;
+        }
+        prefix += 2;
+    }
+    for (i = 0; i < length; i++) {
+        uint8_t elem_width = _flexb_elem_width(&s->stack[start + i * step], size, i + prefix);
+        if (elem_width > bit_width) {
+            bit_width = elem_width;
+        }
+    }
+    uint8_t byte_width;
+    if ((rc = _flexb_stream_align(s, bit_width, &byte_width)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    if (keys != NULL) {
+        if ((rc = _flexb_stream_write_any(s, keys, byte_width)) != FLEXB_SUCCESS ||
+            (rc = _flexb_stream_write_uint(s, 1 << keys->min_width, byte_width)) != FLEXB_SUCCESS) {
+            return rc;
+        }
+    }
+    if ((rc = _flexb_stream_write_uint(s, length, byte_width)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    uint64_t loc = _flexb_stream_size(s);
+    for (i = 0; i < length; i++) {
+        if ((rc = _flexb_stream_write_any(s, &s->stack[start + i * step], byte_width)) != FLEXB_SUCCESS) {
+            return rc;
+        }
+    }
+    for (i = 0; !typed && i < length; i++) {
+        uint8_t packed_type = _flexb_packed_type(&s->stack[start + i * step], bit_width);
+        if ((rc = _flexb_stream_write(s, &packed_type, 1)) != FLEXB_SUCCESS) {
+            return rc;
+        }
+    }
+    result->v.u = loc;
+    result->key = NULL;
+    result->min_width = bit_width;
+    if (keys != NULL) {
+        result->type = FLEXB_MAP;
+    } else if (typed) {
+        // Only the keys of a map are written as a typed vector.
+        result->type = FLEXB_VECTOR_KEY;
+    } else {
+        result->type = FLEXB_VECTOR;
+    }
+    return FLEXB_SUCCESS;
+}
+
+static inline void _flexb_stream_pop(FLEXB_stream *s, size_t start) {
+    while (s->stack_len > start) {
+        free(s->stack[--s->stack_len].key);
+    }
+    s->open_len--;
+}
+
+static inline int _flexb_stream_push_value(FLEXB_stream *s, const _FLEXB_value* value) {
+    int rc = _flexb_stream_grow(s);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    s->stack[s->stack_len++] = *value;
+    return FLEXB_SUCCESS;
+}
+
+static inline int flexb_stream_end_vector(FLEXB_stream *s) {
+    if (s == NULL || s->open_len == 0 || s->open[s->open_len - 1].is_map) {
+        return EINVAL;
+    }
+    if (s->error) {
+        return s->error;
+    }
+    size_t start = s->open[s->open_len - 1].start;
+    _FLEXB_value vec;
+    int rc = _flexb_stream_vector(s, start, s->stack_len - start, 1, 0, NULL, &vec);
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    _flexb_stream_pop(s, start);
+    return _flexb_stream_push_value(s, &vec);
+}
+
+static inline int _flexb_stream_key_compare(const void* a, const void* b) {
+    return strcmp(((const _FLEXB_value*)a)->key, ((const _FLEXB_value*)b)->key);
+}
+
+static inline int flexb_stream_end_map(FLEXB_stream *s) {
+    if (s == NULL || s->open_len == 0 || !s->open[s->open_len - 1].is_map) {
+        return EINVAL;
+    }
+    if (s->error) {
+        return s->error;
+    }
+    size_t start = s->open[s->open_len - 1].start;
+    if ((s->stack_len - start) % 2 != 0) {
+        return EINVAL;
+    }
+    size_t length = (s->stack_len - start) / 2;
+    size_t i;
+    // Sort key/value pairs together so the reader can bsearch the keys.
+    if (length > 1) {
+        qsort(s->stack + start, length, 2 * sizeof(_FLEXB_value), _flexb_stream_key_compare);
+    }
+    for (i = 1; i < length; i++) {
+        if (strcmp(s->stack[start + 2 * i - 2].key, s->stack[start + 2 * i].key) == 0) {
+            return EINVAL;
+        }
+    }
+    _FLEXB_value keys;
+    _FLEXB_value map;
+    int rc = _flexb_stream_vector(s, start, length, 2, 1, NULL, &keys);
+    if (rc == FLEXB_SUCCESS) {
+        rc = _flexb_stream_vector(s, start + 1, length, 2, 0, &keys, &map);
+    }
+    if (rc != FLEXB_SUCCESS) {
+        return rc;
+    }
+    _flexb_stream_pop(s, start);
+    return _flexb_stream_push_value(s, &map);
+}
+
+/* Write the root value and flush everything to the fd. */
+static inline int flexb_stream_finish(FLEXB_stream *s) {
+    if (s == NULL || s->open_len != 0 || s->stack_len != 1) {
+        return EINVAL;
+    }
+    if (s->error) {
+        return s->error;
+    }
+    const _FLEXB_value* root = &s->stack[0];
+    uint8_t byte_width;
+    uint8_t trailer[2];
+    int rc = _flexb_stream_align(s, _flexb_elem_width(root, _flexb_stream_size(s), 0), &byte_width);
+    if (rc != FLEXB_SUCCESS || (rc = _flexb_stream_write_any(s, root, byte_width)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    trailer[0] = _flexb_packed_type(root, 0);
+    trailer[1] = byte_width;
+    if ((rc = _flexb_stream_write(s, trailer, 2)) != FLEXB_SUCCESS) {
+        return rc;
+    }
+    s->stack_len = 0;
+    return _flexb_stream_flush(s);
+}
+
+#endif
@@ -1,30 +1,13 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "flexb/flexb.h"
+#include "flexb/flexb_container.h"
+#include "flexb/flexb_stream.h"
+#include "flexb/flexb_bind.h"
+#include "test.h"
 
-int tests_failed = 0;
-int tests_passed = 0;
-
-void test_failed (const char* test, const char* file, int line) {
-    printf("!FAILED: %s:%03d %s\n", file, line, test);
-    tests_failed++;
-}
-
-void test_passed (const char* test, const char* file, int line) {
-    printf(" PASSED: %s:%03d %s\n", file, line, test);
-    tests_passed++;
-}
-
-void test_ok(int passed, const char* test, const char* file, int line) {
-    if (!passed) {
-        test_failed(test, file, line);
-    } else {
-        test_passed(test, file, line);
-    }
-}
-
-#define IS_OK(exp) do{ test_ok((exp), #exp, __FILE__, __LINE__); } while(0)
 static char byte_int_bytes[]  = {1,4,1}; // 0x01
 static char short_int_bytes[] = {1,2,5,2}; // 0x0201
 static char int_bytes[]       = {1,2,3,4,6,4}; // 0x04030201
@@ -43,9 +26,6 @@ static char bad_type[]  = {1,108,1}; // Corrupted byte width
 static char typed_int_vector[]  = {3,1,2,3,3,44,1}; // [1, 2, 3]
 static char typed_int3_vector[]  = {1,2,3,3,80,1}; // [1, 2, 3]
 
-// { vec: [ -100, "Fred", 4.0, false ], bar: [ 1, 2, 3 ], bar3: [ 1, 2, 3 ], foo: 100, bool: true, mymap: { foo: "Fred", sbool1 : "true", sbool2: "false", sbool3: "0", sbool3: "1" } }
-static char map_bytes[]={ 118, 101, 99, 0, 4, 70, 114, 101, 100, 0, 0, 0, 0, 0, 128, 64, 4, 156, 13, 7, 0, 4, 20, 34, 104, 98, 97, 114, 0, 3, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 98, 97, 114, 51, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 98, 111, 111, 108, 0, 102, 111, 111, 0, 109, 121, 109, 97, 112, 0, 115, 98, 111, 111, 108, 49, 0, 4, 116, 114, 117, 101, 0, 115, 98, 111, 111, 108, 50, 0, 5, 102, 97, 108, 115, 101, 0, 115, 98, 111, 111, 108, 51, 0, 1, 49, 0, 115, 98, 111, 111, 108, 52, 0, 1, 48, 0, 5, 58, 49, 37, 24, 15, 5, 1, 5, 128, 49, 37, 24, 15, 20, 20, 20, 20, 20, 6, 119, 100, 84, 80, 77, 149, 0, 0, 8, 0, 0, 0, 1, 0, 0, 0, 6, 0, 0, 0, 131, 0, 0, 0, 118, 0, 0, 0, 1, 0, 0, 0, 0, 0, 200, 66, 47, 0, 0, 0, 167, 0, 0, 0, 46, 78, 106, 14, 36, 40, 30, 38, 1 };
-
 void int_tests() {
     int64_t num = 0;
     FLEXB_ref ref = {};
@@ -145,6 +125,60 @@ void map_tests() {
     IS_OK(num3 == 4.0);
 }
 
+void map_scan_tests() {
+    size_t index = 0;
+    const char* key = NULL;
+    FLEXB_ref ref = {};
+    FLEXB_map map = {};
+    FLEXB_map_iter iter = {};
+
+    IS_OK(flexb_set_root(map_bytes, sizeof(map_bytes), NULL, &ref) == 0);
+    IS_OK(flexb_as_map(map_bytes, &ref, &map) == 0);
+
+    IS_OK(flexb_map_lower_bound(map_bytes, &map, "bar", &index) == 0);
+    IS_OK(index == 0);
+    IS_OK(flexb_map_upper_bound(map_bytes, &map, "bar", &index) == 0);
+    IS_OK(index == 1);
+    IS_OK(flexb_map_lower_bound(map_bytes, &map, "c", &index) == 0);
+    IS_OK(index == 3);
+    IS_OK(flexb_map_lower_bound(map_bytes, &map, "z", &index) == 0);
+    IS_OK(index == 6);
+
+    IS_OK(flexb_map_prefix(map_bytes, &map, "bar", &iter) == 0);
+    IS_OK(flexb_map_next(map_bytes, &iter, &key, &ref) == 0);
+    IS_OK(strcmp(key, "bar") == 0);
+    IS_OK(ref.type == FLEXB_VECTOR_INT);
+    IS_OK(flexb_map_next(map_bytes, &iter, &key, &ref) == 0);
+    IS_OK(strcmp(key, "bar3") == 0);
+    IS_OK(flexb_map_next(map_bytes, &iter, &key, &ref) == FLEXB_NOT_FOUND);
+
+    IS_OK(flexb_map_prefix(map_bytes, &map, "b", &iter) == 0);
+    IS_OK(iter.end - iter.index == 3);
+    IS_OK(flexb_map_prefix(map_bytes, &map, "", &iter) == 0);
+    IS_OK(iter.end - iter.index == 6);
+    IS_OK(flexb_map_prefix(map_bytes, &map, "x", &iter) == 0);
+    IS_OK(flexb_map_next(map_bytes, &iter, &key, &ref) == FLEXB_NOT_FOUND);
+
+    IS_OK(flexb_map_range(map_bytes, &map, "bool", "mymap", &iter) == 0);
+    IS_OK(flexb_map_next(map_bytes, &iter, &key, &ref) == 0);
+    IS_OK(strcmp(key, "bool") == 0);
+    IS_OK(ref.type == FLEXB_BOOL);
+    IS_OK(flexb_map_next(map_bytes, &iter, NULL, &ref) == 0);
+    IS_OK(ref.type == FLEXB_FLOAT);
+    IS_OK(flexb_map_next(map_bytes, &iter, &key, &ref) == FLEXB_NOT_FOUND);
+
+    IS_OK(flexb_map_range(map_bytes, &map, "mymap", NULL, &iter) == 0);
+    IS_OK(iter.end - iter.index == 2);
+    IS_OK(flexb_map_range(map_bytes, &map, "z", "a", &iter) == 0);
+    IS_OK(iter.end == iter.index);
+
+    // Keys that resolve before root are not compared
+    const void* late_root = map_bytes + sizeof(map_bytes) - 1;
+    IS_OK(flexb_map_lower_bound(late_root, &map, "bar", &index) == FLEXB_CORRUPTED);
+    IS_OK(flexb_map_upper_bound(late_root, &map, "bar", &index) == FLEXB_CORRUPTED);
+    IS_OK(flexb_map_range(late_root, &map, "bool", NULL, &iter) == FLEXB_CORRUPTED);
+    IS_OK(flexb_map_prefix(late_root, &map, "b", &iter) == FLEXB_CORRUPTED);
+}
 
 void vec_tests() {
     uint64_t num = 0;
@@ -197,14 +231,473 @@ void bad_data () {
     IS_OK(flexb_set_root(bad_type, 3, NULL, &ref) == FLEXB_CORRUPTED);
 }
 
+void container_tests() {
+    char path[] = "/tmp/flexb_test_XXXXXX";
+    int64_t num = 0;
+    size_t index = 0;
+    FLEXB_ref ref = {};
+    FLEXB_root root = {};
+    FLEXB_container c = {};
+    FLEXB_container_iter iter = {};
+    FLEXB_container_writer w = {};
+
+    int fd = mkstemp(path);
+    IS_OK(fd >= 0);
+    close(fd);
+
+    IS_OK(flexb_container_writer_open(path, &w) == 0);
+    IS_OK(flexb_container_append(&w, byte_int_bytes, sizeof(byte_int_bytes), "a") == 0);
+    IS_OK(flexb_container_append(&w, map_bytes, sizeof(map_bytes), NULL) == 0);
+    IS_OK(flexb_container_append(&w, short_int_bytes, sizeof(short_int_bytes), "m") == 0);
+    IS_OK(flexb_container_append(&w, int_bytes, sizeof(int_bytes), "c") == EINVAL);
+    IS_OK(flexb_container_writer_close(&w) == 0);
+
+    // Reopening appends after the existing records
+    IS_OK(flexb_container_writer_open(path, &w) == 0);
+    IS_OK(w.first == 3);
+    IS_OK(w.count == 0);
+    IS_OK(flexb_container_append(&w, int_bytes, sizeof(int_bytes), "l") == EINVAL);
+    IS_OK(flexb_container_append(&w, int_bytes, sizeof(int_bytes), "x") == 0);
+    IS_OK(flexb_container_writer_close(&w) == 0);
+
+    IS_OK(flexb_container_open(path, &c) == 0);
+    IS_OK(c.count == 4);
+    IS_OK(c.segment_count == 2);
+    IS_OK(flexb_container_get(&c, 4, &root, &ref) == FLEXB_NOT_FOUND);
+
+    IS_OK(flexb_container_get(&c, 1, &root, &ref) == 0);
+    IS_OK(ref.type == FLEXB_MAP);
+    IS_OK((const char*)root.end - (const char*)root.start == sizeof(map_bytes));
+
+    IS_OK(flexb_container_get(&c, 3, &root, &ref) == 0);
+    IS_OK(flexb_as_int64(&ref, &num) == 0);
+    IS_OK(num == 0x04030201);
+
+    IS_OK(flexb_container_seek(&c, "0", &index) == FLEXB_NOT_FOUND);
+    IS_OK(flexb_container_seek(&c, "b", &index) == 0);
+    IS_OK(index == 0);
+    IS_OK(flexb_container_seek(&c, "m", &index) == 0);
+    IS_OK(index == 2);
+    IS_OK(flexb_container_seek(&c, "z", &index) == 0);
+    IS_OK(index == 3);
+
+    IS_OK(flexb_container_iter_init(&c, 2, &iter) == 0);
+    IS_OK(flexb_container_next(&iter, &root, &ref) == 0);
+    IS_OK(flexb_as_int64(&ref, &num) == 0);
+    IS_OK(num == 0x0201);
+    IS_OK(flexb_container_next(&iter, &root, &ref) == 0);
+    IS_OK(flexb_as_int64(&ref, &num) == 0);
+    IS_OK(num == 0x04030201);
+    IS_OK(flexb_container_next(&iter, &root, &ref) == FLEXB_NOT_FOUND);
+
+    // A corrupted key table is rejected before any key is read
+    FLEXB_container copied = {};
+    uint8_t* copy = malloc(c.size);
+    size_t keys_offset = c.segments[0].keys - c.data;
+    memcpy(copy, c.data, c.size);
+    IS_OK(flexb_container_init(copy, c.size, &copied) == 0);
+    IS_OK(copied.count == 4 && copied.key_count == 3);
+    flexb_container_close(&copied);
+    _flexb_put_uint64(copy + keys_offset + 8, c.size * 2);
+    IS_OK(flexb_container_init(copy, c.size, &copied) == FLEXB_CORRUPTED);
+    memcpy(copy, c.data, c.size);
+    _flexb_put_uint64(copy + keys_offset, 3);
+    IS_OK(flexb_container_init(copy, c.size, &copied) == FLEXB_CORRUPTED);
+    free(copy);
+    flexb_container_close(&c);
+
+    // A writer dying before it commits leaves the old records readable, even
+    // when the torn tail ends with something that looks like a trailer
+    IS_OK(flexb_container_writer_open(path, &w) == 0);
+    IS_OK(flexb_container_append(&w, byte_int_bytes, sizeof(byte_int_bytes), NULL) == 0);
+    IS_OK(flexb_container_append(&w, "FXBC", 4, NULL) == 0);
+    close(w.fd);
+    _flexb_container_writer_free(&w);
+    IS_OK(flexb_container_open(path, &c) == 0);
+    IS_OK(c.count == 4);
+    IS_OK(flexb_container_get(&c, 3, &root, &ref) == 0);
+    IS_OK(flexb_as_int64(&ref, &num) == 0);
+    IS_OK(num == 0x04030201);
+    flexb_container_close(&c);
+
+    IS_OK(flexb_container_writer_open(path, &w) == 0);
+    IS_OK(w.first == 4);
+    IS_OK(flexb_container_append(&w, short_int_bytes, sizeof(short_int_bytes), "y") == 0);
+    IS_OK(flexb_container_writer_close(&w) == 0);
+    IS_OK(flexb_container_open(path, &c) == 0);
+    IS_OK(c.count == 5);
+    IS_OK(flexb_container_get(&c, 4, &root, &ref) == 0);
+    IS_OK(flexb_as_int64(&ref, &num) == 0);
+    IS_OK(num == 0x0201);
+    IS_OK(flexb_container_get(&c, 1, &root, &ref) == 0);
+    IS_OK(ref.type == FLEXB_MAP);
+    IS_OK(flexb_container_seek(&c, "z", &index) == 0);
+    IS_OK(index == 4);
+    IS_OK(flexb_container_seek(&c, "x", &index) == 0);
+    IS_OK(index == 3);
+    flexb_container_close(&c);
+
+    IS_OK(flexb_container_init(map_bytes, sizeof(map_bytes), &c) == FLEXB_CORRUPTED);
+
+    // Each session only adds its own records and index to the file
+    struct stat st;
+    int i;
+    IS_OK(truncate(path, 0) == 0);
+    IS_OK(flexb_container_writer_open(path, &w) == 0);
+    IS_OK(flexb_container_writer_close(&w) == 0);
+    IS_OK(flexb_container_open(path, &c) == 0);
+    IS_OK(c.count == 0);
+    IS_OK(flexb_container_seek(&c, "a", &index) == FLEXB_NOT_FOUND);
+    flexb_container_close(&c);
+    FLEXB_container before = {};
+    for (i = 0; i < 10; i++) {
+        IS_OK(flexb_container_writer_open(path, &w) == 0);
+        IS_OK(w.first == (uint64_t)i * 3);
+        flexb_container_append(&w, int_bytes, sizeof(int_bytes), NULL);
+        flexb_container_append(&w, short_int_bytes, sizeof(short_int_bytes), NULL);
+        flexb_container_append(&w, byte_int_bytes, sizeof(byte_int_bytes), NULL);
+        IS_OK(flexb_container_writer_close(&w) == 0);
+        if (i == 4) {
+            IS_OK(flexb_container_open(path, &before) == 0);
+        }
+    }
+    IS_OK(stat(path, &st) == 0);
+    IS_OK((size_t)st.st_size == FLEXB_CONTAINER_HEADER_SIZE +
+          10 * (sizeof(int_bytes) + sizeof(short_int_bytes) + sizeof(byte_int_bytes) + 4 * 8 + FLEXB_CONTAINER_TRAILER_SIZE));
+
+    // A reader keeps its view while the writer appends
+    IS_OK(before.count == 15);
+    IS_OK(flexb_container_get(&before, 14, &root, &ref) == 0);
+    IS_OK(flexb_as_int64(&ref, &num) == 0);
+    IS_OK(num == 1);
+    flexb_container_close(&before);
+
+    IS_OK(flexb_container_open(path, &c) == 0);
+    IS_OK(c.count == 30);
+    IS_OK(c.segment_count == 10);
+    IS_OK(flexb_container_iter_init(&c, 1, &iter) == 0);
+    int64_t sum = 0;
+    while (flexb_container_next(&iter, &root, &ref) == 0 && flexb_as_int64(&ref, &num) == 0) {
+        sum += num;
+    }
+    IS_OK(iter.index == 30);
+    IS_OK(sum == 10 * (0x04030201 + 0x0201 + 1) - 0x04030201);
+    flexb_container_close(&c);
+    unlink(path);
+}
+
+void stream_tests() {
+    char path[] = "/tmp/flexb_test_XXXXXX";
+    static const char blob_bytes[] = {1, 0, 2};
+    int64_t num = 0;
+    uint64_t num2 = 0;
+    double num3 = 0.0;
+    size_t length = 0;
+    size_t i = 0;
+    const char* str = NULL;
+    FLEXB_ref ref  = {};
+    FLEXB_ref ref2 = {};
+    FLEXB_ref ref3 = {};
+    FLEXB_map map  = {};
+    FLEXB_vec vec  = {};
+    FLEXB_stream s = {};
+
+    int fd = mkstemp(path);
+    IS_OK(fd >= 0);
+    // A tiny buffer forces flushes in the middle of the document
+    IS_OK(flexb_stream_init(&s, fd, 16) == 0);
+    IS_OK(flexb_stream_start_map(&s) == 0);
+    IS_OK(flexb_stream_int(&s, 1) == EINVAL);
+    IS_OK(flexb_stream_key(&s, "name") == 0);
+    IS_OK(flexb_stream_string(&s, "Fred") == 0);
+    IS_OK(flexb_stream_key(&s, "age") == 0);
+    IS_OK(flexb_stream_int(&s, -42) == 0);
+    IS_OK(flexb_stream_key(&s, "blob") == 0);
+    IS_OK(flexb_stream_blob(&s, blob_bytes, sizeof(blob_bytes)) == 0);
+    IS_OK(flexb_stream_key(&s, "vec") == 0);
+    IS_OK(flexb_stream_start_vector(&s) == 0);
+    IS_OK(flexb_stream_key(&s, "bad") == EINVAL);
+    IS_OK(flexb_stream_float(&s, 2.5) == 0);
+    IS_OK(flexb_stream_null(&s) == 0);
+    IS_OK(flexb_stream_start_map(&s) == 0);
+    IS_OK(flexb_stream_key(&s, "x") == 0);
+    IS_OK(flexb_stream_uint(&s, 300) == 0);
+    IS_OK(flexb_stream_end_map(&s) == 0);
+    IS_OK(flexb_stream_end_vector(&s) == 0);
+    IS_OK(flexb_stream_key(&s, "big") == 0);
+    IS_OK(flexb_stream_start_vector(&s) == 0);
+    for (i = 0; i < 1000 && flexb_stream_int(&s, (int64_t)i * 1000) == 0; i++);
+    IS_OK(i == 1000);
+    IS_OK(flexb_stream_end_vector(&s) == 0);
+    IS_OK(flexb_stream_finish(&s) == EINVAL);
+    IS_OK(flexb_stream_end_map(&s) == 0);
+    IS_OK(flexb_stream_finish(&s) == 0);
+    IS_OK(s.buf_len == 0);
+    flexb_stream_free(&s);
+
+    off_t size = lseek(fd, 0, SEEK_END);
+    const void* data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    IS_OK(data != MAP_FAILED);
+    close(fd);
+    unlink(path);
+
+    IS_OK(flexb_set_root(data, size, NULL, &ref) == 0);
+    IS_OK(flexb_as_map(data, &ref, &map) == 0);
+    IS_OK(map.values.length == 5);
+
+    IS_OK(flexb_map_get_ref(data, &map, "name", &ref2) == 0);
+    IS_OK(flexb_as_str(data, &ref2, &str) == 0);
+    IS_OK(strcmp(str, "Fred") == 0);
+
+    IS_OK(flexb_map_get_ref(data, &map, "age", &ref2) == 0);
+    IS_OK(flexb_as_int64(&ref2, &num) == 0);
+    IS_OK(num == -42);
+
+    IS_OK(flexb_map_get_ref(data, &map, "blob", &ref2) == 0);
+    IS_OK(ref2.type == FLEXB_BLOB);
+    IS_OK(flexb_as_blob(data, &ref2, &str, &length) == 0);
+    IS_OK(length == 3 && memcmp(str, blob_bytes, 3) == 0);
+
+    IS_OK(flexb_map_get_ref(data, &map, "vec", &ref2) == 0);
+    IS_OK(flexb_as_vec(data, &ref2, &vec) == 0);
+    IS_OK(vec.length == 3);
+    IS_OK(flexb_vec_get_ref(data, &vec, 0, &ref3) == 0);
+    IS_OK(flexb_as_float(NULL, &ref3, &num3) == 0);
+    IS_OK(num3 == 2.5);
+    IS_OK(flexb_vec_get_ref(data, &vec, 1, &ref3) == 0);
+    IS_OK(flexb_is_null(&ref3));
+    IS_OK(flexb_vec_get_ref(data, &vec, 2, &ref3) == 0);
+    IS_OK(flexb_as_map(data, &ref3, &map) == 0);
+    IS_OK(flexb_map_get_ref(data, &map, "x", &ref3) == 0);
+    IS_OK(flexb_as_uint64(&ref3, &num2) == 0);
+    IS_OK(num2 == 300);
+
+    IS_OK(flexb_set_root(data, size, NULL, &ref) == 0);
+    IS_OK(flexb_as_map(data, &ref, &map) == 0);
+    IS_OK(flexb_map_get_ref(data, &map, "big", &ref2) == 0);
+    IS_OK(flexb_as_vec(data, &ref2, &vec) == 0);
+    IS_OK(vec.length == 1000);
+    IS_OK(vec.byte_width == 4);
+    IS_OK(flexb_vec_get_ref(data, &vec, 999, &ref3) == 0);
+    IS_OK(flexb_as_int64(&ref3, &num) == 0);
+    IS_OK(num == 999000);
+    munmap((void*)data, size);
+}
+
+/* Open an unlinked temporary file for a stream. */
+int stream_tmp() {
+    char path[] = "/tmp/flexb_test_XXXXXX";
+    int fd = mkstemp(path);
+    IS_OK(fd >= 0);
+    unlink(path);
+    return fd;
+}
+
+/* Finish s and map what it wrote. */
+const void* stream_map(FLEXB_stream *s, size_t *size) {
+    const void* data = MAP_FAILED;
+    IS_OK(flexb_stream_finish(s) == 0);
+    flexb_stream_free(s);
+    *size = lseek(s->fd, 0, SEEK_END);
+    data = mmap(NULL, *size, PROT_READ, MAP_SHARED, s->fd, 0);
+    IS_OK(data != MAP_FAILED);
+    close(s->fd);
+    return data;
+}
+
+void stream_empty_tests() {
+    size_t size = 0;
+    size_t i = 0;
+    const void* data;
+    FLEXB_ref ref  = {};
+    FLEXB_ref ref2 = {};
+    FLEXB_map map  = {};
+    FLEXB_vec vec  = {};
+    FLEXB_stream s = {};
+
+    // Empty map as the root
+    IS_OK(flexb_stream_init(&s, stream_tmp(), 16) == 0);
+    IS_OK(flexb_stream_start_map(&s) == 0);
+    IS_OK(flexb_stream_end_map(&s) == 0);
+    data = stream_map(&s, &size);
+    IS_OK(flexb_set_root(data, size, NULL, &ref) == 0);
+    IS_OK(flexb_as_map(data, &ref, &map) == 0);
+    IS_OK(map.values.length == 0);
+    IS_OK(flexb_map_get_ref(data, &map, "x", &ref2) == FLEXB_NOT_FOUND);
+    munmap((void*)data, size);
+
+    // Empty containers closed with the value stack empty or exactly full
+    IS_OK(flexb_stream_init(&s, stream_tmp(), 16) == 0);
+    IS_OK(flexb_stream_start_vector(&s) == 0);
+    IS_OK(flexb_stream_start_vector(&s) == 0);
+    IS_OK(flexb_stream_end_vector(&s) == 0);
+    for (i = 1; i < 64 && flexb_stream_int(&s, (int64_t)i) == 0; i++);
+    IS_OK(s.stack_len == s.stack_cap);
+    IS_OK(flexb_stream_start_vector(&s) == 0);
+    IS_OK(flexb_stream_end_vector(&s) == 0);
+    IS_OK(flexb_stream_start_map(&s) == 0);
+    IS_OK(flexb_stream_end_map(&s) == 0);
+    IS_OK(flexb_stream_end_vector(&s) == 0);
+    data = stream_map(&s, &size);
+    IS_OK(flexb_set_root(data, size, NULL, &ref) == 0);
+    IS_OK(flexb_as_vec(data, &ref, &vec) == 0);
+    IS_OK(vec.length == 66);
+    IS_OK(flexb_vec_get_ref(data, &vec, 0, &ref2) == 0);
+    IS_OK(ref2.type == FLEXB_VECTOR);
+    IS_OK(flexb_vec_get_ref(data, &vec, 64, &ref2) == 0);
+    IS_OK(ref2.type == FLEXB_VECTOR);
+    IS_OK(flexb_vec_get_ref(data, &vec, 65, &ref2) == 0);
+    IS_OK(flexb_as_map(data, &ref2, &map) == 0);
+    IS_OK(map.values.length == 0);
+    IS_OK(flexb_vec_get_ref(data, &vec, 0, &ref2) == 0);
+    IS_OK(flexb_as_vec(data, &ref2, &vec) == 0);
+    IS_OK(vec.length == 0);
+    munmap((void*)data, size);
+}
+
+typedef struct bind_test {
+    char flag;
+    double foo;
+    int8_t foo8;
+    float missing;
+    FLEXB_map mymap;
+    FLEXB_vec vec;
+    int32_t vec_int;
+} bind_test;
+
+#define BIND_TEST_FIELDS(X, T) \
+    X(T, "bool",  flag,    FLEXB_FIELD_BOOL) \
+    X(T, "foo",   foo,     FLEXB_FIELD_FLOAT) \
+    X(T, "foo",   foo8,    FLEXB_FIELD_INT) \
+    X(T, "mymap", mymap,   FLEXB_FIELD_MAP) \
+    X(T, "nope",  missing, FLEXB_FIELD_FLOAT) \
+    X(T, "vec",   vec,     FLEXB_FIELD_VEC) \
+    X(T, "vec",   vec_int, FLEXB_FIELD_INT)
+
+FLEXB_FIELDS(bind_test_fields, bind_test, BIND_TEST_FIELDS);
+FLEXB_FIELD_BITS(BIND_TEST, BIND_TEST_FIELDS);
+
+typedef struct bind_sign_test {
+    int64_t big_int;
+    uint64_t big_uint;
+    int64_t neg_int;
+    uint64_t neg_uint;
+} bind_sign_test;
+
+#define BIND_SIGN_FIELDS(X, T) \
+    X(T, "big", big_int,  FLEXB_FIELD_INT) \
+    X(T, "big", big_uint, FLEXB_FIELD_UINT) \
+    X(T, "neg", neg_int,  FLEXB_FIELD_INT) \
+    X(T, "neg", neg_uint, FLEXB_FIELD_UINT)
+
+FLEXB_FIELDS(bind_sign_fields, bind_sign_test, BIND_SIGN_FIELDS);
+FLEXB_FIELD_BITS(BIND_SIGN, BIND_SIGN_FIELDS);
+
+typedef struct bind_wide_test {
+    int32_t first;
+    int32_t middle;
+    int32_t absent;
+    int32_t last;
+} bind_wide_test;
+
+#define BIND_WIDE_FIELDS(X, T) \
+    X(T, "k00000",  first,  FLEXB_FIELD_INT) \
+    X(T, "k05000",  middle, FLEXB_FIELD_INT) \
+    X(T, "k05000x", absent, FLEXB_FIELD_INT) \
+    X(T, "k09999",  last,   FLEXB_FIELD_INT)
+
+FLEXB_FIELDS(bind_wide_fields, bind_wide_test, BIND_WIDE_FIELDS);
+FLEXB_FIELD_BITS(BIND_WIDE, BIND_WIDE_FIELDS);
+
+static const FLEXB_field bind_unsorted_fields[] = {
+    { "vec", offsetof(bind_test, vec), sizeof(FLEXB_vec), FLEXB_FIELD_VEC },
+    { "foo", offsetof(bind_test, foo), sizeof(double), FLEXB_FIELD_FLOAT },
+};
+
+void bind_tests() {
+    uint64_t missing = 0;
+    uint64_t invalid = 0;
+    FLEXB_ref ref = {};
+    FLEXB_map map = {};
+    bind_test out = {};
+
+    IS_OK(flexb_set_root(map_bytes, sizeof(map_bytes), NULL, &ref) == 0);
+    IS_OK(flexb_as_map(map_bytes, &ref, &map) == 0);
+    IS_OK(BIND_TEST_COUNT == 7);
+    IS_OK(flexb_map_bind(map_bytes, &map, bind_test_fields, BIND_TEST_COUNT, &out, &missing, &invalid) == 0);
+    IS_OK(missing == FLEXB_FIELD_BIT(BIND_TEST_missing));
+    IS_OK(invalid == (FLEXB_FIELD_BIT(BIND_TEST_foo8) | FLEXB_FIELD_BIT(BIND_TEST_vec_int)));
+    IS_OK(out.flag == 1);
+    IS_OK(out.foo == 100.0);
+    IS_OK(out.foo8 == 0);
+    IS_OK(out.vec.length == 4);
+    IS_OK(out.mymap.keys.type == FLEXB_KEY);
+
+    memset(&out, 0, sizeof(out));
+    IS_OK(flexb_map_bind(map_bytes, &map, bind_unsorted_fields, 2, &out, &missing, &invalid) == 0);
+    IS_OK(missing == 0 && invalid == 0);
+    IS_OK(out.vec.length == 4);
+    IS_OK(out.foo == 100.0);
+
+    // 64 bit members reject values of the wrong sign
+    size_t size = 0;
+    const void* data;
+    bind_sign_test sign = {};
+    FLEXB_stream s = {};
+    IS_OK(flexb_stream_init(&s, stream_tmp(), 0) == 0);
+    IS_OK(flexb_stream_start_map(&s) == 0);
+    IS_OK(flexb_stream_key(&s, "big") == 0);
+    IS_OK(flexb_stream_uint(&s, UINT64_MAX) == 0);
+    IS_OK(flexb_stream_key(&s, "neg") == 0);
+    IS_OK(flexb_stream_int(&s, -1) == 0);
+    IS_OK(flexb_stream_end_map(&s) == 0);
+    data = stream_map(&s, &size);
+    IS_OK(flexb_set_root(data, size, NULL, &ref) == 0);
+    IS_OK(flexb_as_map(data, &ref, &map) == 0);
+    IS_OK(flexb_map_bind(data, &map, bind_sign_fields, BIND_SIGN_COUNT, &sign, &missing, &invalid) == 0);
+    IS_OK(missing == 0);
+    IS_OK(invalid == (FLEXB_FIELD_BIT(BIND_SIGN_big_int) | FLEXB_FIELD_BIT(BIND_SIGN_neg_uint)));
+    IS_OK(sign.big_int == 0 && sign.neg_uint == 0);
+    IS_OK(sign.big_uint == UINT64_MAX);
+    IS_OK(sign.neg_int == -1);
+    munmap((void*)data, size);
+
+    // A map much wider than the field list
+    char key[16];
+    int i;
+    bind_wide_test wide = {};
+    IS_OK(flexb_stream_init(&s, stream_tmp(), 0) == 0);
+    IS_OK(flexb_stream_start_map(&s) == 0);
+    for (i = 0; i < 10000; i++) {
+        snprintf(key, sizeof(key), "k%05d", i);
+        flexb_stream_key(&s, key);
+        flexb_stream_int(&s, i);
+    }
+    IS_OK(flexb_stream_end_map(&s) == 0);
+    data = stream_map(&s, &size);
+    IS_OK(flexb_set_root(data, size, NULL, &ref) == 0);
+    IS_OK(flexb_as_map(data, &ref, &map) == 0);
+    IS_OK(map.keys.length == 10000);
+    IS_OK(flexb_map_bind(data, &map, bind_wide_fields, BIND_WIDE_COUNT, &wide, &missing, &invalid) == 0);
+    IS_OK(missing == FLEXB_FIELD_BIT(BIND_WIDE_absent));
+    IS_OK(invalid == 0);
+    IS_OK(wide.first == 0 && wide.middle == 5000 && wide.last == 9999);
+    IS_OK(wide.absent == 0);
+    munmap((void*)data, size);
+}
 
 int main() {
     int results = 0;
     int_tests();
     uint_tests();
     map_tests();
+    map_scan_tests();
     vec_tests();
     bad_data();
+    container_tests();
+    stream_tests();
+    stream_empty_tests();
+    bind_tests();
 
     if (tests_failed) {
         results = 1;
@@ -0,0 +1,34 @@
+#ifndef __FLEXB_TEST__
+#define __FLEXB_TEST__
+
+#include <stdio.h>
+
+/* Harness and fixtures shared by the C and C++ tests. */
+
+int tests_failed = 0;
+int tests_passed = 0;
+
+void test_failed (const char* test, const char* file, int line) {
+    printf("!FAILED: %s:%03d %s\n", file, line, test);
+    tests_failed++;
+}
+
+void test_passed (const char* test, const char* file, int line) {
+    printf(" PASSED: %s:%03d %s\n", file, line, test);
+    tests_passed++;
+}
+
+void test_ok(int passed, const char* test, const char* file, int line) {
+    if (!passed) {
+        test_failed(test, file, line);
+    } else {
+        test_passed(test, file, line);
+    }
+}
+
+#define IS_OK(exp) do{ test_ok((exp), #exp, __FILE__, __LINE__); } while(0)
+
+// { vec: [ -100, "Fred", 4.0, false ], bar: [ 1, 2, 3 ], bar3: [ 1, 2, 3 ], foo: 100, bool: true, mymap: { foo: "Fred", sbool1 : "true", sbool2: "false", sbool3: "0", sbool3: "1" } }
+static unsigned char map_bytes[]={ 118, 101, 99, 0, 4, 70, 114, 101, 100, 0, 0, 0, 0, 0, 128, 64, 4, 156, 13, 7, 0, 4, 20, 34, 104, 98, 97, 114, 0, 3, 0, 0, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 98, 97, 114, 51, 0, 1, 0, 0, 0, 2, 0, 0, 0, 3, 0, 0, 0, 98, 111, 111, 108, 0, 102, 111, 111, 0, 109, 121, 109, 97, 112, 0, 115, 98, 111, 111, 108, 49, 0, 4, 116, 114, 117, 101, 0, 115, 98, 111, 111, 108, 50, 0, 5, 102, 97, 108, 115, 101, 0, 115, 98, 111, 111, 108, 51, 0, 1, 49, 0, 115, 98, 111, 111, 108, 52, 0, 1, 48, 0, 5, 58, 49, 37, 24, 15, 5, 1, 5, 128, 49, 37, 24, 15, 20, 20, 20, 20, 20, 6, 119, 100, 84, 80, 77, 149, 0, 0, 8, 0, 0, 0, 1, 0, 0, 0, 6, 0, 0, 0, 131, 0, 0, 0, 118, 0, 0, 0, 1, 0, 0, 0, 0, 0, 200, 66, 47, 0, 0, 0, 167, 0, 0, 0, 46, 78, 106, 14, 36, 40, 30, 38, 1 };
+
+#endif
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <utility>
+#include "flexb/flexb.h"
+#include "flexb/flexb_bind.h"
+#include "test.h"
+
+struct bind_test {
+    bool flag;
+    float foo;
+    short foo_short;
+    FLEXB_map mymap;
+    double missing;
+    FLEXB_vec vec;
+};
+
+struct bind_other {
+    bool flag;
+};
+
+static const auto bind_test_fields = flexb::make_fields(
+    FLEXB_BIND_MEMBER(bind_test, "bool", flag),
+    FLEXB_BIND_MEMBER(bind_test, "foo", foo),
+    FLEXB_BIND_MEMBER(bind_test, "foo", foo_short),
+    FLEXB_BIND_MEMBER(bind_test, "mymap", mymap),
+    FLEXB_BIND_MEMBER(bind_test, "nope", missing),
+    FLEXB_BIND_MEMBER(bind_test, "vec", vec));
+
+// A field table only binds the struct it was built for
+template <typename F, typename T, typename = void>
+struct can_bind : std::false_type {};
+
+template <typename F, typename T>
+struct can_bind<F, T, decltype((void)flexb::map_bind(NULL, std::declval<const FLEXB_map&>(), std::declval<const F&>(),
+        std::declval<T&>(), std::declval<uint64_t&>(), std::declval<uint64_t&>()))> : std::true_type {};
+
+static_assert(can_bind<decltype(bind_test_fields), bind_test>::value, "fields bind their own struct");
+static_assert(!can_bind<decltype(bind_test_fields), bind_other>::value, "fields do not bind another struct");
+
+int main() {
+    uint64_t missing = 0;
+    uint64_t invalid = 0;
+    FLEXB_ref ref = {};
+    FLEXB_map map = {};
+    bind_test out = {};
+
+    IS_OK(bind_test_fields.items[0].kind == FLEXB_FIELD_BOOL);
+    IS_OK(bind_test_fields.items[1].kind == FLEXB_FIELD_FLOAT);
+    IS_OK(bind_test_fields.items[2].kind == FLEXB_FIELD_INT);
+    IS_OK(bind_test_fields.items[3].kind == FLEXB_FIELD_MAP);
+    IS_OK(bind_test_fields.items[5].kind == FLEXB_FIELD_VEC);
+    IS_OK(flexb::field_kind<uint16_t>::value == FLEXB_FIELD_UINT);
+    IS_OK(flexb::field_kind<const char*>::value == FLEXB_FIELD_STR);
+
+    IS_OK(flexb_set_root(map_bytes, sizeof(map_bytes), NULL, &ref) == 0);
+    IS_OK(flexb_as_map(map_bytes, &ref, &map) == 0);
+    IS_OK(flexb::map_bind(map_bytes, map, bind_test_fields, out, missing, invalid) == 0);
+    IS_OK(missing == FLEXB_FIELD_BIT(4));
+    IS_OK(invalid == FLEXB_FIELD_BIT(2));
+    IS_OK(out.flag);
+    IS_OK(out.foo == 100.0f);
+    IS_OK(out.vec.length == 4);
+
+    printf("Tests succeeded %d\n",  tests_passed);
+    printf("Tests failed %d\n",  tests_failed);
+    return tests_failed ? 1 : 0;
+}